@@ -22,6 +22,15 @@
 #include "stm32f1xx_hal.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "drivers/timebase/timebase.h"
+#include "drivers/ir/ir.h"
+#include "drivers/ir/ir_tim.h"
+#include "drivers/i2c/i2c.h"
+#include "drivers/gpio/gpio.h"
+#include "drivers/buttons/buttons.h"
+#include "drivers/gpio/gpio_fast.h"
+#include "drivers/prof/prof.h"
+#include "sched/sched.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -187,6 +196,9 @@ void SysTick_Handler(void)
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  timebase_tick();
+  buttons_tick();
+  sched_tick();
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -200,19 +212,94 @@ void SysTick_Handler(void)
 
 /* USER CODE BEGIN 1 */
 /* comments are lowercase */
+/* exti 0..4: direct-register dispatch with GPIO_EXTI_FAST, else the hal path.
+ * the exti_isr probe spans the whole vector so both paths can be compared.
+ */
 void EXTI0_IRQHandler(void)
 {
+  PROF_SCOPE(exti_isr);
+#if GPIO_EXTI_FAST
+  gpio_exti_fast(0);
+#else
   HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_0);
+#endif
 }
 
 void EXTI1_IRQHandler(void)
 {
+  PROF_SCOPE(exti_isr);
+#if GPIO_EXTI_FAST
+  gpio_exti_fast(1);
+#else
   HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_1);
+#endif
 }
 
 void EXTI2_IRQHandler(void)
 {
+  PROF_SCOPE(exti_isr);
+#if GPIO_EXTI_FAST
+  gpio_exti_fast(2);
+#else
   HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_2);
+#endif
 }
 
+void EXTI3_IRQHandler(void)
+{
+  PROF_SCOPE(exti_isr);
+#if GPIO_EXTI_FAST
+  gpio_exti_fast(3);
+#else
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_3);
+#endif
+}
+
+void EXTI4_IRQHandler(void)
+{
+  PROF_SCOPE(exti_isr);
+#if GPIO_EXTI_FAST
+  gpio_exti_fast(4);
+#else
+  HAL_GPIO_EXTI_IRQHandler(GPIO_PIN_4);
+#endif
+}
+
+/* shared vectors: every pending line of the group, via gpio_attach_irq() callbacks */
+void EXTI9_5_IRQHandler(void)
+{
+  PROF_SCOPE(exti_isr);
+  gpio_exti_demux(GPIO_PIN_5 | GPIO_PIN_6 | GPIO_PIN_7 | GPIO_PIN_8 | GPIO_PIN_9);
+}
+
+void EXTI15_10_IRQHandler(void)
+{
+  PROF_SCOPE(exti_isr);
+  gpio_exti_demux(GPIO_PIN_10 | GPIO_PIN_11 | GPIO_PIN_12 | GPIO_PIN_13 | GPIO_PIN_14 |
+                  GPIO_PIN_15);
+}
+
+/* i2c1 tx dma (channel 6) and i2c1 event/error, used by i2c_write_dma() */
+void DMA1_Channel6_IRQHandler(void)
+{
+  i2c_dma_tx_irq(I2C1);
+}
+
+void I2C1_EV_IRQHandler(void)
+{
+  i2c_ev_irq(I2C1);
+}
+
+void I2C1_ER_IRQHandler(void)
+{
+  i2c_er_irq(I2C1);
+}
+
+#if IR_BACKEND == IR_BACKEND_TIM2
+void TIM2_IRQHandler(void)
+{
+  ir_tim_irq();
+}
+#endif
+
 /* USER CODE END 1 */
@@ -0,0 +1,537 @@
+/* fake stm32f1 hal + cmsis for the host simulator
+ * comments are lowercase
+ *
+ * only the subset the firmware uses is provided. peripherals are plain
+ * structs in host memory, so register-level code (dwt, exti, tim2) compiles
+ * and runs unchanged; hal calls are implemented in sim_hal.c.
+ */
+
+#ifndef SIM_STM32F1XX_HAL_H
+#define SIM_STM32F1XX_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* ---- core ------------------------------------------------------------- */
+
+    typedef enum
+    {
+        NonMaskableInt_IRQn = -14,
+        HardFault_IRQn = -13,
+        MemoryManagement_IRQn = -12,
+        BusFault_IRQn = -11,
+        UsageFault_IRQn = -10,
+        SVCall_IRQn = -5,
+        DebugMonitor_IRQn = -4,
+        PendSV_IRQn = -2,
+        SysTick_IRQn = -1,
+        EXTI0_IRQn = 6,
+        EXTI1_IRQn = 7,
+        EXTI2_IRQn = 8,
+        EXTI3_IRQn = 9,
+        EXTI4_IRQn = 10,
+        DMA1_Channel4_IRQn = 14,
+        DMA1_Channel6_IRQn = 16,
+        EXTI9_5_IRQn = 23,
+        TIM2_IRQn = 28,
+        I2C1_EV_IRQn = 31,
+        I2C1_ER_IRQn = 32,
+        I2C2_EV_IRQn = 33,
+        I2C2_ER_IRQn = 34,
+        EXTI15_10_IRQn = 40,
+        SIM_IRQ_COUNT = 43
+    } IRQn_Type;
+
+    /* primask is emulated with one recursive lock shared by all "isrs" */
+    void __disable_irq(void);
+    void __enable_irq(void);
+    uint32_t __get_PRIMASK(void);
+    void __set_PRIMASK(uint32_t primask);
+
+#define __NOP() ((void) 0)
+#define __WFI() sim_wfi()
+#define __DSB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __RBIT(x) sim_rbit(x)
+#define __CLZ(x) ((uint8_t) ((x) ? __builtin_clz(x) : 32))
+
+    void sim_wfi(void);
+    uint32_t sim_rbit(uint32_t v);
+
+    extern uint32_t SystemCoreClock;
+
+    typedef struct
+    {
+        volatile uint32_t CTRL;
+        volatile uint32_t CYCCNT;
+    } DWT_Type;
+
+    typedef struct
+    {
+        volatile uint32_t DHCSR;
+        volatile uint32_t DCRSR;
+        volatile uint32_t DCRDR;
+        volatile uint32_t DEMCR;
+    } CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk (1UL << 24)
+
+    /* ---- peripherals ------------------------------------------------------ */
+
+    typedef struct
+    {
+        volatile uint32_t CRL;
+        volatile uint32_t CRH;
+        volatile uint32_t IDR;
+        volatile uint32_t ODR;
+        volatile uint32_t BSRR;
+        volatile uint32_t BRR;
+        volatile uint32_t LCKR;
+    } GPIO_TypeDef;
+
+    typedef struct
+    {
+        volatile uint32_t IMR;
+        volatile uint32_t EMR;
+        volatile uint32_t RTSR;
+        volatile uint32_t FTSR;
+        volatile uint32_t SWIER;
+        volatile uint32_t PR;
+    } EXTI_TypeDef;
+
+    typedef struct
+    {
+        volatile uint32_t EVCR;
+        volatile uint32_t MAPR;
+        volatile uint32_t EXTICR[4];
+    } AFIO_TypeDef;
+
+    typedef struct
+    {
+        volatile uint32_t CR1;
+        volatile uint32_t CR2;
+        volatile uint32_t OAR1;
+        volatile uint32_t OAR2;
+        volatile uint32_t DR;
+        volatile uint32_t SR1;
+        volatile uint32_t SR2;
+        volatile uint32_t CCR;
+        volatile uint32_t TRISE;
+    } I2C_TypeDef;
+
+#define I2C_CR1_SWRST (1UL << 15)
+#define I2C_SR2_BUSY (1UL << 1)
+
+    typedef struct
+    {
+        volatile uint32_t CR1;
+        volatile uint32_t CR2;
+        volatile uint32_t SMCR;
+        volatile uint32_t DIER;
+        volatile uint32_t SR;
+        volatile uint32_t EGR;
+        volatile uint32_t CCMR1;
+        volatile uint32_t CCMR2;
+        volatile uint32_t CCER;
+        volatile uint32_t CNT;
+        volatile uint32_t PSC;
+        volatile uint32_t ARR;
+        volatile uint32_t RCR;
+        volatile uint32_t CCR1;
+        volatile uint32_t CCR2;
+        volatile uint32_t CCR3;
+        volatile uint32_t CCR4;
+        volatile uint32_t BDTR;
+        volatile uint32_t DCR;
+        volatile uint32_t DMAR;
+    } TIM_TypeDef;
+
+    typedef struct
+    {
+        volatile uint32_t CCR;
+        volatile uint32_t CNDTR;
+        volatile uint32_t CPAR;
+        volatile uint32_t CMAR;
+    } DMA_Channel_TypeDef;
+
+    extern GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc, sim_gpiod, sim_gpioe;
+    extern EXTI_TypeDef sim_exti;
+    extern AFIO_TypeDef sim_afio;
+    extern I2C_TypeDef sim_i2c1, sim_i2c2;
+    extern TIM_TypeDef sim_tim2;
+    extern DMA_Channel_TypeDef sim_dma1_ch4, sim_dma1_ch6;
+    extern DWT_Type sim_dwt;
+    extern CoreDebug_Type sim_coredebug;
+
+#define GPIOA (&sim_gpioa)
+#define GPIOB (&sim_gpiob)
+#define GPIOC (&sim_gpioc)
+#define GPIOD (&sim_gpiod)
+#define GPIOE (&sim_gpioe)
+#define EXTI (&sim_exti)
+#define AFIO (&sim_afio)
+#define I2C1 (&sim_i2c1)
+#define I2C2 (&sim_i2c2)
+#define TIM2 (&sim_tim2)
+#define DMA1_Channel4 (&sim_dma1_ch4)
+#define DMA1_Channel6 (&sim_dma1_ch6)
+#define DWT (&sim_dwt)
+#define CoreDebug (&sim_coredebug)
+
+    /* ---- hal common ------------------------------------------------------- */
+
+    typedef enum
+    {
+        HAL_OK = 0x00U,
+        HAL_ERROR = 0x01U,
+        HAL_BUSY = 0x02U,
+        HAL_TIMEOUT = 0x03U
+    } HAL_StatusTypeDef;
+
+    HAL_StatusTypeDef HAL_Init(void);
+    void HAL_IncTick(void);
+    uint32_t HAL_GetTick(void);
+    void HAL_Delay(uint32_t delay_ms);
+
+    void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub);
+    void HAL_NVIC_EnableIRQ(IRQn_Type irqn);
+    void HAL_NVIC_DisableIRQ(IRQn_Type irqn);
+    uint32_t HAL_SYSTICK_Config(uint32_t ticks);
+    void HAL_SYSTICK_CLKSourceConfig(uint32_t source);
+
+#define SYSTICK_CLKSOURCE_HCLK 0x00000004U
+
+    /* ---- rcc -------------------------------------------------------------- */
+
+    typedef struct
+    {
+        uint32_t PLLState;
+        uint32_t PLLSource;
+        uint32_t PLLMUL;
+    } RCC_PLLInitTypeDef;
+
+    typedef struct
+    {
+        uint32_t OscillatorType;
+        uint32_t HSEState;
+        uint32_t HSEPredivValue;
+        uint32_t LSEState;
+        uint32_t HSIState;
+        uint32_t HSICalibrationValue;
+        uint32_t LSIState;
+        RCC_PLLInitTypeDef PLL;
+    } RCC_OscInitTypeDef;
+
+    typedef struct
+    {
+        uint32_t ClockType;
+        uint32_t SYSCLKSource;
+        uint32_t AHBCLKDivider;
+        uint32_t APB1CLKDivider;
+        uint32_t APB2CLKDivider;
+    } RCC_ClkInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_HSE 0x00000001U
+#define RCC_OSCILLATORTYPE_HSI 0x00000002U
+#define RCC_HSE_ON 0x00010000U
+#define RCC_HSE_PREDIV_DIV1 0x00000000U
+#define RCC_HSI_ON 0x00000001U
+#define RCC_HSICALIBRATION_DEFAULT 0x10U
+#define RCC_PLL_OFF 0x00000001U
+#define RCC_PLL_ON 0x00000002U
+#define RCC_PLLSOURCE_HSE 0x00010000U
+#define RCC_PLL_MUL9 0x001C0000U
+#define RCC_CLOCKTYPE_SYSCLK 0x00000001U
+#define RCC_CLOCKTYPE_HCLK 0x00000002U
+#define RCC_CLOCKTYPE_PCLK1 0x00000004U
+#define RCC_CLOCKTYPE_PCLK2 0x00000008U
+#define RCC_SYSCLKSOURCE_HSI 0x00000000U
+#define RCC_SYSCLKSOURCE_PLLCLK 0x00000002U
+#define RCC_SYSCLK_DIV1 0x00000000U
+#define RCC_HCLK_DIV1 0x00000000U
+#define RCC_HCLK_DIV2 0x00000400U
+#define FLASH_LATENCY_0 0x00000000U
+#define FLASH_LATENCY_2 0x00000002U
+
+    HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *osc);
+    HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *clk, uint32_t latency);
+    uint32_t HAL_RCC_GetHCLKFreq(void);
+    uint32_t HAL_RCC_GetPCLK1Freq(void);
+
+/* clock gates and remaps have no effect off-target */
+#define __HAL_RCC_GPIOA_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_GPIOD_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_GPIOE_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_AFIO_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_I2C1_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_I2C2_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_TIM2_CLK_ENABLE() ((void) 0)
+#define __HAL_RCC_DMA1_CLK_ENABLE() ((void) 0)
+#define __HAL_AFIO_REMAP_I2C1_ENABLE() ((void) 0)
+#define __HAL_AFIO_REMAP_I2C1_DISABLE() ((void) 0)
+
+    /* ---- gpio ------------------------------------------------------------- */
+
+    typedef enum
+    {
+        GPIO_PIN_RESET = 0U,
+        GPIO_PIN_SET
+    } GPIO_PinState;
+
+    typedef struct
+    {
+        uint32_t Pin;
+        uint32_t Mode;
+        uint32_t Pull;
+        uint32_t Speed;
+    } GPIO_InitTypeDef;
+
+#define GPIO_PIN_0 ((uint16_t) 0x0001)
+#define GPIO_PIN_1 ((uint16_t) 0x0002)
+#define GPIO_PIN_2 ((uint16_t) 0x0004)
+#define GPIO_PIN_3 ((uint16_t) 0x0008)
+#define GPIO_PIN_4 ((uint16_t) 0x0010)
+#define GPIO_PIN_5 ((uint16_t) 0x0020)
+#define GPIO_PIN_6 ((uint16_t) 0x0040)
+#define GPIO_PIN_7 ((uint16_t) 0x0080)
+#define GPIO_PIN_8 ((uint16_t) 0x0100)
+#define GPIO_PIN_9 ((uint16_t) 0x0200)
+#define GPIO_PIN_10 ((uint16_t) 0x0400)
+#define GPIO_PIN_11 ((uint16_t) 0x0800)
+#define GPIO_PIN_12 ((uint16_t) 0x1000)
+#define GPIO_PIN_13 ((uint16_t) 0x2000)
+#define GPIO_PIN_14 ((uint16_t) 0x4000)
+#define GPIO_PIN_15 ((uint16_t) 0x8000)
+#define GPIO_PIN_All ((uint16_t) 0xFFFF)
+
+#define GPIO_MODE_INPUT 0x00000000U
+#define GPIO_MODE_OUTPUT_PP 0x00000001U
+#define GPIO_MODE_OUTPUT_OD 0x00000011U
+#define GPIO_MODE_AF_PP 0x00000002U
+#define GPIO_MODE_AF_OD 0x00000012U
+#define GPIO_MODE_AF_INPUT GPIO_MODE_INPUT
+#define GPIO_MODE_ANALOG 0x00000003U
+#define GPIO_MODE_IT_RISING 0x10110000U
+#define GPIO_MODE_IT_FALLING 0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING 0x10310000U
+
+#define GPIO_NOPULL 0x00000000U
+#define GPIO_PULLUP 0x00000001U
+#define GPIO_PULLDOWN 0x00000002U
+
+#define GPIO_SPEED_FREQ_LOW 0x00000002U
+#define GPIO_SPEED_FREQ_MEDIUM 0x00000001U
+#define GPIO_SPEED_FREQ_HIGH 0x00000003U
+
+    void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init);
+    void HAL_GPIO_DeInit(GPIO_TypeDef *port, uint32_t pin);
+    GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin);
+    void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state);
+    void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin);
+    void HAL_GPIO_EXTI_IRQHandler(uint16_t pin);
+    void HAL_GPIO_EXTI_Callback(uint16_t pin);
+
+    /* ---- dma -------------------------------------------------------------- */
+
+    typedef struct
+    {
+        uint32_t Direction;
+        uint32_t PeriphInc;
+        uint32_t MemInc;
+        uint32_t PeriphDataAlignment;
+        uint32_t MemDataAlignment;
+        uint32_t Mode;
+        uint32_t Priority;
+    } DMA_InitTypeDef;
+
+    typedef struct __DMA_HandleTypeDef
+    {
+        DMA_Channel_TypeDef *Instance;
+        DMA_InitTypeDef Init;
+        void *Parent;
+    } DMA_HandleTypeDef;
+
+#define DMA_PERIPH_TO_MEMORY 0x00000000U
+#define DMA_MEMORY_TO_PERIPH 0x00000010U
+#define DMA_PINC_DISABLE 0x00000000U
+#define DMA_MINC_ENABLE 0x00000080U
+#define DMA_PDATAALIGN_BYTE 0x00000000U
+#define DMA_MDATAALIGN_BYTE 0x00000000U
+#define DMA_NORMAL 0x00000000U
+#define DMA_PRIORITY_LOW 0x00000000U
+#define DMA_PRIORITY_MEDIUM 0x00001000U
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)                               \
+    do                                                                                             \
+    {                                                                                              \
+        (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__);                                       \
+        (__DMA_HANDLE__).Parent = (__HANDLE__);                                                    \
+    } while (0U)
+
+    HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+    HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+    void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+
+    /* ---- i2c -------------------------------------------------------------- */
+
+    typedef struct
+    {
+        uint32_t ClockSpeed;
+        uint32_t DutyCycle;
+        uint32_t OwnAddress1;
+        uint32_t AddressingMode;
+        uint32_t DualAddressMode;
+        uint32_t OwnAddress2;
+        uint32_t GeneralCallMode;
+        uint32_t NoStretchMode;
+    } I2C_InitTypeDef;
+
+    typedef enum
+    {
+        HAL_I2C_STATE_RESET = 0x00U,
+        HAL_I2C_STATE_READY = 0x20U,
+        HAL_I2C_STATE_BUSY_TX = 0x21U
+    } HAL_I2C_StateTypeDef;
+
+    typedef struct __I2C_HandleTypeDef
+    {
+        I2C_TypeDef *Instance;
+        I2C_InitTypeDef Init;
+        DMA_HandleTypeDef *hdmatx;
+        DMA_HandleTypeDef *hdmarx;
+        volatile HAL_I2C_StateTypeDef State;
+        volatile uint32_t ErrorCode;
+    } I2C_HandleTypeDef;
+
+#define I2C_DUTYCYCLE_2 0x00000000U
+#define I2C_DUTYCYCLE_16_9 0x00004000U
+#define I2C_ADDRESSINGMODE_7BIT 0x00004000U
+#define I2C_DUALADDRESS_DISABLE 0x00000000U
+#define I2C_GENERALCALL_DISABLE 0x00000000U
+#define I2C_NOSTRETCH_DISABLE 0x00000000U
+
+/* sequential transfer options (repeated start between frames) */
+#define I2C_FIRST_FRAME 0x00000008U
+#define I2C_LAST_FRAME 0x00000020U
+#define I2C_FIRST_AND_LAST_FRAME 0x00000010U
+
+    HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+    HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+    HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c,
+                                              uint16_t addr,
+                                              uint8_t *data,
+                                              uint16_t len,
+                                              uint32_t timeout);
+    HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c,
+                                             uint16_t addr,
+                                             uint8_t *data,
+                                             uint16_t len,
+                                             uint32_t timeout);
+    HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c,
+                                            uint16_t addr,
+                                            uint32_t trials,
+                                            uint32_t timeout);
+    HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c,
+                                                  uint16_t addr,
+                                                  uint8_t *data,
+                                                  uint16_t len);
+    HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c,
+                                                 uint16_t addr,
+                                                 uint8_t *data,
+                                                 uint16_t len);
+    HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c,
+                                                uint16_t addr,
+                                                uint8_t *data,
+                                                uint16_t len);
+    HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c,
+                                                     uint16_t addr,
+                                                     uint8_t *data,
+                                                     uint16_t len,
+                                                     uint32_t options);
+    HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef *hi2c,
+                                                    uint16_t addr,
+                                                    uint8_t *data,
+                                                    uint16_t len,
+                                                    uint32_t options);
+    HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef *hi2c, uint16_t addr);
+    HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+    void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c);
+    void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c);
+    void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c);
+    void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c);
+    void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+    void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c);
+
+    /* ---- flash ------------------------------------------------------------ */
+
+#define FLASH_BASE 0x08000000UL
+#define FLASH_PAGE_SIZE 0x400U
+#define FLASH_TYPEPROGRAM_HALFWORD 0x01U
+#define FLASH_TYPEERASE_PAGES 0x00U
+
+    typedef struct
+    {
+        uint32_t TypeErase;
+        uint32_t Banks;
+        uint32_t PageAddress;
+        uint32_t NbPages;
+    } FLASH_EraseInitTypeDef;
+
+    HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+    HAL_StatusTypeDef HAL_FLASH_Lock(void);
+    HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t addr, uint64_t data);
+    HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *init, uint32_t *page_error);
+
+    /* the fake flash lives in host memory: reads go through here instead of
+ * dereferencing the address
+ */
+    const uint8_t *sim_flash_ptr(uint32_t addr);
+
+    /* ---- tim2 (register level only) --------------------------------------- */
+
+#define TIM_CR1_CEN (1U << 0)
+#define TIM_CR1_CKD_1 (1U << 9)
+#define TIM_DIER_CC1IE (1U << 1)
+#define TIM_DIER_CC2IE (1U << 2)
+#define TIM_DIER_CC3IE (1U << 3)
+#define TIM_DIER_CC4IE (1U << 4)
+#define TIM_SR_CC1IF (1U << 1)
+#define TIM_SR_CC2IF (1U << 2)
+#define TIM_SR_CC3IF (1U << 3)
+#define TIM_SR_CC4IF (1U << 4)
+#define TIM_SR_CC1OF (1U << 9)
+#define TIM_SR_CC2OF (1U << 10)
+#define TIM_SR_CC3OF (1U << 11)
+#define TIM_SR_CC4OF (1U << 12)
+#define TIM_EGR_UG (1U << 0)
+#define TIM_CCMR1_CC1S_Pos 0U
+#define TIM_CCMR1_IC1F_Pos 4U
+#define TIM_CCMR1_CC2S_Pos 8U
+#define TIM_CCMR1_IC2F_Pos 12U
+#define TIM_CCMR2_CC3S_Pos 0U
+#define TIM_CCMR2_IC3F_Pos 4U
+#define TIM_CCMR2_CC4S_Pos 8U
+#define TIM_CCMR2_IC4F_Pos 12U
+#define TIM_CCER_CC1E (1U << 0)
+#define TIM_CCER_CC1P (1U << 1)
+#define TIM_CCER_CC2E (1U << 4)
+#define TIM_CCER_CC2P (1U << 5)
+#define TIM_CCER_CC3E (1U << 8)
+#define TIM_CCER_CC3P (1U << 9)
+#define TIM_CCER_CC4E (1U << 12)
+#define TIM_CCER_CC4P (1U << 13)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_STM32F1XX_HAL_H */
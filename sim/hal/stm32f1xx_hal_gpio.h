@@ -0,0 +1,2 @@
+/* fake hal sub-header: everything lives in stm32f1xx_hal.h */
+#include "stm32f1xx_hal.h"
@@ -0,0 +1,115 @@
+#ifndef SIM_H
+#define SIM_H
+
+/* host simulator control api (not linked into the firmware)
+ * comments are lowercase
+ *
+ * the firmware runs single-threaded on the host. "interrupts" fire only
+ * while virtual time advances: in __WFI() (the main loop going idle) and in
+ * HAL_Delay(). each wake advances to the next due systick or scheduled input
+ * edge, so a run is fully deterministic.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "stm32f1xx_hal.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* ---- virtual time ----------------------------------------------------- */
+
+    uint64_t sim_now_us(void);
+
+    /* advance virtual time, firing systick (1 khz) and due input edges */
+    void sim_advance_to_us(uint64_t t_us);
+
+    /* ---- input stimulus --------------------------------------------------- */
+
+    /* schedule a pin level change; edges matching the exti config latch the
+ * pending bit and run the vector if its nvic line is enabled
+ */
+    bool sim_schedule_input(uint64_t t_us, GPIO_TypeDef *port, uint16_t pin, bool level);
+
+    /* drive a pin right now (runs the exti vector immediately if it fires) */
+    void sim_gpio_input(GPIO_TypeDef *port, uint16_t pin, bool level);
+
+    /* set an input level without edge detection (the caller plays the isr) */
+    void sim_gpio_set(GPIO_TypeDef *port, uint16_t pin, bool level);
+
+    /* inputs not yet applied */
+    size_t sim_pending_inputs(void);
+
+    /* end of the run: once inputs are exhausted and time passes end_us, the
+ * next __WFI() calls on_end (which should report and exit)
+ */
+    void sim_set_end(uint64_t end_us, void (*on_end)(void));
+
+    bool sim_irq_enabled(IRQn_Type irqn);
+
+    /* ---- i2c / ssd1306 model ---------------------------------------------- */
+
+    /* bus time is modeled from the scl clock HAL_I2C_Init() would program
+ * (ClockSpeed, DutyCycle and pclk1; rise time ignored): 9 clocks per byte,
+ * one for each start and stop, and SIM_I2C_GAP_NS between transactions for
+ * the isr that starts the next one
+ */
+    typedef struct
+    {
+        uint32_t transactions; /* start..stop sequences */
+        uint32_t bytes;        /* bytes on the wire incl. address bytes */
+        uint64_t bus_ns;       /* modeled time the bus was busy */
+        uint32_t scl_hz;       /* scl clock of the last HAL_I2C_Init() */
+    } sim_i2c_stats_t;
+
+    sim_i2c_stats_t sim_i2c_stats(void);
+
+    /* stuck bus: the first transfer at or after at_us hangs with the slave
+ * holding sda low (sr2.busy stays set); sda is let go after `clocks` scl
+ * pulses driven by gpio on i2c1's pins (pb6/pb7), 0 = never
+ */
+    void sim_i2c_jam(uint64_t at_us, uint32_t clocks);
+
+    /* decode one i2c write (control byte + commands/data) into the panel model */
+    void sim_ssd1306_write(const uint8_t *data, size_t len);
+
+    /* panel contents: ascii art to a stream, or a plain pbm image */
+    void sim_ssd1306_dump(FILE *out);
+    bool sim_ssd1306_save_pbm(const char *path);
+
+    /* ---- flash ------------------------------------------------------------ */
+
+    /* 64 kb from FLASH_BASE, erased at start. as on the f103 the core stalls
+ * while the flash works: SIM_FLASH_PROG_US per halfword, SIM_FLASH_ERASE_US
+ * per page. input edges in that time only latch their exti line, and the
+ * vector runs (and timestamps them) once the flash is done
+ */
+    typedef struct
+    {
+        uint32_t programs;   /* halfwords programmed */
+        uint32_t erases;     /* pages erased */
+        uint64_t stall_us;   /* core stalled on the flash */
+        uint32_t late_edges; /* input changes that came during a stall */
+    } sim_flash_stats_t;
+
+    sim_flash_stats_t sim_flash_stats(void);
+
+    /* flash image from / to a file; a missing file loads as erased flash */
+    bool sim_flash_load(const char *path);
+    bool sim_flash_save(const char *path);
+
+    /* power cut during the nth program or erase (from 1): the halfword gets
+ * only its low byte, the page only its first half erased, then on_cut runs
+ * (which should report, save the image and exit)
+ */
+    void sim_flash_cut(uint32_t nth, void (*on_cut)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SIM_H */
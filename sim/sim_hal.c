@@ -0,0 +1,1055 @@
+/* fake stm32f1 hal for the host simulator
+ * comments are lowercase
+ */
+
+#include "sim.h"
+#include "stm32f1xx_it.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* ---- peripheral instances ------------------------------------------------- */
+
+GPIO_TypeDef sim_gpioa, sim_gpiob, sim_gpioc, sim_gpiod, sim_gpioe;
+EXTI_TypeDef sim_exti;
+AFIO_TypeDef sim_afio;
+I2C_TypeDef sim_i2c1, sim_i2c2;
+TIM_TypeDef sim_tim2;
+DMA_Channel_TypeDef sim_dma1_ch4, sim_dma1_ch6;
+DWT_Type sim_dwt;
+CoreDebug_Type sim_coredebug;
+
+uint32_t SystemCoreClock = 8000000U;
+
+/* ssd1306 on the bus (7-bit) */
+#define SIM_SSD1306_ADDR7 0x3Cu
+
+/* ---- interrupt model ------------------------------------------------------ */
+
+/* vectors the firmware may or may not define (weak refs resolve to null) */
+extern void EXTI0_IRQHandler(void) __attribute__((weak));
+extern void EXTI1_IRQHandler(void) __attribute__((weak));
+extern void EXTI2_IRQHandler(void) __attribute__((weak));
+extern void EXTI3_IRQHandler(void) __attribute__((weak));
+extern void EXTI4_IRQHandler(void) __attribute__((weak));
+extern void EXTI9_5_IRQHandler(void) __attribute__((weak));
+extern void EXTI15_10_IRQHandler(void) __attribute__((weak));
+
+static uint32_t s_primask = 0;
+static bool s_nvic_on[SIM_IRQ_COUNT];
+
+/* interrupts raised while primask was set run when it is cleared again */
+static bool s_systick_pending = false;
+static void deliver_pending(void);
+
+/* vectors running; the firmware's isrs do not preempt each other, so nothing
+ * is delivered while one runs (e.g. when it restores primask)
+ */
+static uint32_t s_active = 0;
+
+static void run_vector(void (*vec)(void))
+{
+    s_active++;
+    vec();
+    s_active--;
+}
+
+void __disable_irq(void)
+{
+    s_primask = 1;
+}
+
+void __enable_irq(void)
+{
+    s_primask = 0;
+    deliver_pending();
+}
+
+uint32_t __get_PRIMASK(void)
+{
+    return s_primask;
+}
+
+void __set_PRIMASK(uint32_t primask)
+{
+    s_primask = primask & 1u;
+    if (!s_primask)
+        deliver_pending();
+}
+
+uint32_t sim_rbit(uint32_t v)
+{
+    uint32_t r = 0;
+    for (uint32_t i = 0; i < 32u; i++)
+    {
+        r = (r << 1) | (v & 1u);
+        v >>= 1;
+    }
+    return r;
+}
+
+bool sim_irq_enabled(IRQn_Type irqn)
+{
+    return (irqn >= 0 && irqn < SIM_IRQ_COUNT) ? s_nvic_on[irqn] : false;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irqn, uint32_t preempt, uint32_t sub)
+{
+    /* isrs never nest in the simulator, so priorities do not matter */
+    (void) irqn;
+    (void) preempt;
+    (void) sub;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irqn)
+{
+    if (irqn >= 0 && irqn < SIM_IRQ_COUNT)
+        s_nvic_on[irqn] = true;
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type irqn)
+{
+    if (irqn >= 0 && irqn < SIM_IRQ_COUNT)
+        s_nvic_on[irqn] = false;
+}
+
+static IRQn_Type exti_irqn(uint32_t line)
+{
+    if (line <= 4u)
+        return (IRQn_Type) (EXTI0_IRQn + (int) line);
+    return (line <= 9u) ? EXTI9_5_IRQn : EXTI15_10_IRQn;
+}
+
+static void (*exti_vector(IRQn_Type irqn))(void)
+{
+    switch (irqn)
+    {
+        case EXTI0_IRQn:
+            return EXTI0_IRQHandler;
+        case EXTI1_IRQn:
+            return EXTI1_IRQHandler;
+        case EXTI2_IRQn:
+            return EXTI2_IRQHandler;
+        case EXTI3_IRQn:
+            return EXTI3_IRQHandler;
+        case EXTI4_IRQn:
+            return EXTI4_IRQHandler;
+        case EXTI9_5_IRQn:
+            return EXTI9_5_IRQHandler;
+        case EXTI15_10_IRQn:
+            return EXTI15_10_IRQHandler;
+        default:
+            return NULL;
+    }
+}
+
+static void deliver_pending(void)
+{
+    if (s_active || (!s_systick_pending && !(sim_exti.PR & 0xFFFFu)))
+        return;
+
+    /* lowest line first, rescanning after each vector for lines it let pend */
+    while (!s_primask)
+    {
+        if (s_systick_pending)
+        {
+            s_systick_pending = false;
+            run_vector(SysTick_Handler);
+            continue;
+        }
+
+        uint32_t line = 0;
+        void (*vec)(void) = NULL;
+        for (; line < 16u; line++)
+        {
+            IRQn_Type irqn = exti_irqn(line);
+            if ((sim_exti.PR & (1u << line)) && s_nvic_on[irqn] && exti_vector(irqn))
+            {
+                vec = exti_vector(irqn);
+                break;
+            }
+        }
+        if (!vec)
+            return;
+
+        run_vector(vec);
+        sim_exti.PR &= ~(1u << line);
+    }
+}
+
+/* ---- virtual time --------------------------------------------------------- */
+
+static uint64_t s_now_us = 0;
+static volatile uint32_t s_tick = 0;
+
+/* scheduled pin changes, kept sorted by time (stable for equal times) */
+typedef struct
+{
+    uint64_t t_us;
+    GPIO_TypeDef *port;
+    uint16_t pin;
+    bool level;
+} sim_input_t;
+
+static sim_input_t *s_inputs = NULL;
+static size_t s_inputs_len = 0, s_inputs_cap = 0, s_inputs_next = 0;
+
+static uint64_t s_end_us = 0;
+static void (*s_on_end)(void) = NULL;
+
+uint64_t sim_now_us(void)
+{
+    return s_now_us;
+}
+
+static void set_time(uint64_t t_us)
+{
+    s_now_us = t_us;
+
+    /* dwt->cyccnt follows hclk once the trace block has been enabled */
+    if ((sim_coredebug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk) &&
+        (sim_dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk))
+    {
+        sim_dwt.CYCCNT = (uint32_t) (t_us * (SystemCoreClock / 1000000U));
+    }
+}
+
+/* inputs scheduled for the same instant all change before any vector runs, so
+ * their lines pend together as they would on silicon
+ */
+static void fire_inputs_until(uint64_t t_us)
+{
+    while (s_inputs_next < s_inputs_len && s_inputs[s_inputs_next].t_us <= t_us)
+    {
+        uint64_t at = s_inputs[s_inputs_next].t_us;
+        if (at > s_now_us)
+            set_time(at);
+
+        uint32_t primask = s_primask;
+        s_primask = 1;
+        while (s_inputs_next < s_inputs_len && s_inputs[s_inputs_next].t_us == at)
+        {
+            const sim_input_t *in = &s_inputs[s_inputs_next++];
+            sim_gpio_input(in->port, in->pin, in->level);
+        }
+        s_primask = primask;
+        if (!primask)
+            deliver_pending();
+    }
+}
+
+void sim_advance_to_us(uint64_t t_us)
+{
+    while (s_now_us < t_us)
+    {
+        uint64_t next_tick = (s_now_us / 1000u + 1u) * 1000u;
+        uint64_t step = (next_tick < t_us) ? next_tick : t_us;
+
+        fire_inputs_until(step);
+        set_time(step);
+
+        if (step == next_tick)
+        {
+            /* one pending bit: ticks missed while masked collapse, as on silicon */
+            if (s_primask || s_active)
+                s_systick_pending = true;
+            else
+                run_vector(SysTick_Handler);
+        }
+    }
+    fire_inputs_until(t_us);
+}
+
+/* idle: sleep until the next interrupt, or end the run */
+void sim_wfi(void)
+{
+    if (s_inputs_next >= s_inputs_len && s_now_us >= s_end_us && s_on_end)
+    {
+        s_on_end();
+        exit(0);
+    }
+
+    uint64_t next_tick = (s_now_us / 1000u + 1u) * 1000u;
+    uint64_t wake = next_tick;
+    if (s_inputs_next < s_inputs_len && s_inputs[s_inputs_next].t_us < wake)
+    {
+        wake = s_inputs[s_inputs_next].t_us;
+    }
+
+    if (wake <= s_now_us)
+    {
+        fire_inputs_until(s_now_us);
+        return;
+    }
+    sim_advance_to_us(wake);
+}
+
+bool sim_schedule_input(uint64_t t_us, GPIO_TypeDef *port, uint16_t pin, bool level)
+{
+    if (s_inputs_len == s_inputs_cap)
+    {
+        size_t cap = s_inputs_cap ? s_inputs_cap * 2u : 1024u;
+        sim_input_t *p = realloc(s_inputs, cap * sizeof(*p));
+        if (!p)
+            return false;
+        s_inputs = p;
+        s_inputs_cap = cap;
+    }
+
+    /* insertion from the back: scenarios are generated almost in order */
+    size_t i = s_inputs_len++;
+    while (i > s_inputs_next && s_inputs[i - 1u].t_us > t_us)
+    {
+        s_inputs[i] = s_inputs[i - 1u];
+        i--;
+    }
+    s_inputs[i] = (sim_input_t){t_us, port, pin, level};
+    return true;
+}
+
+size_t sim_pending_inputs(void)
+{
+    return s_inputs_len - s_inputs_next;
+}
+
+void sim_set_end(uint64_t end_us, void (*on_end)(void))
+{
+    s_end_us = end_us;
+    s_on_end = on_end;
+}
+
+/* ---- hal core ------------------------------------------------------------- */
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+    s_tick = 0;
+    return HAL_OK;
+}
+
+void HAL_IncTick(void)
+{
+    s_tick++;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return s_tick;
+}
+
+void HAL_Delay(uint32_t delay_ms)
+{
+    sim_advance_to_us(s_now_us + (uint64_t) delay_ms * 1000u);
+}
+
+uint32_t HAL_SYSTICK_Config(uint32_t ticks)
+{
+    (void) ticks;
+    return 0;
+}
+
+void HAL_SYSTICK_CLKSourceConfig(uint32_t source)
+{
+    (void) source;
+}
+
+static bool s_pll_on = false;
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *osc)
+{
+    s_pll_on = osc && (osc->PLL.PLLState == RCC_PLL_ON);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *clk, uint32_t latency)
+{
+    (void) latency;
+    bool pll = clk && (clk->SYSCLKSource == RCC_SYSCLKSOURCE_PLLCLK) && s_pll_on;
+    SystemCoreClock = pll ? 72000000U : 8000000U;
+    return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+    return (SystemCoreClock > 36000000U) ? SystemCoreClock / 2U : SystemCoreClock;
+}
+
+/* ---- gpio + exti ---------------------------------------------------------- */
+
+static uint32_t port_index(const GPIO_TypeDef *port)
+{
+    if (port == GPIOA)
+        return 0;
+    if (port == GPIOB)
+        return 1;
+    if (port == GPIOC)
+        return 2;
+    if (port == GPIOD)
+        return 3;
+    return 4;
+}
+
+/* output pins per port: their idr mirrors odr */
+static uint16_t s_out_mask[5];
+
+/* stuck-bus model (i2c section): counts scl clocks, holds sda low */
+static void jam_on_gpio(GPIO_TypeDef *port, uint32_t old_odr);
+
+void HAL_GPIO_Init(GPIO_TypeDef *port, GPIO_InitTypeDef *init)
+{
+    uint32_t idx = port_index(port);
+
+    for (uint32_t line = 0; line < 16u; line++)
+    {
+        uint32_t bit = 1u << line;
+        if (!(init->Pin & bit))
+            continue;
+
+        bool out = (init->Mode == GPIO_MODE_OUTPUT_PP || init->Mode == GPIO_MODE_OUTPUT_OD ||
+                    init->Mode == GPIO_MODE_AF_PP || init->Mode == GPIO_MODE_AF_OD);
+        if (out)
+        {
+            s_out_mask[idx] |= (uint16_t) bit;
+            port->IDR = (port->IDR & ~bit) | (port->ODR & bit);
+        }
+        else
+        {
+            s_out_mask[idx] &= (uint16_t) ~bit;
+            if (init->Pull == GPIO_PULLUP)
+                port->IDR |= bit;
+            else if (init->Pull == GPIO_PULLDOWN)
+                port->IDR &= ~bit;
+        }
+
+        /* exti: route the line to this port and arm the selected edges */
+        bool it = (init->Mode == GPIO_MODE_IT_RISING || init->Mode == GPIO_MODE_IT_FALLING ||
+                   init->Mode == GPIO_MODE_IT_RISING_FALLING);
+        if (it)
+        {
+            uint32_t shift = (line % 4u) * 4u;
+            sim_afio.EXTICR[line / 4u] =
+                    (sim_afio.EXTICR[line / 4u] & ~(0xFu << shift)) | (idx << shift);
+            sim_exti.IMR |= bit;
+            if (init->Mode != GPIO_MODE_IT_FALLING)
+                sim_exti.RTSR |= bit;
+            else
+                sim_exti.RTSR &= ~bit;
+            if (init->Mode != GPIO_MODE_IT_RISING)
+                sim_exti.FTSR |= bit;
+            else
+                sim_exti.FTSR &= ~bit;
+        }
+    }
+    jam_on_gpio(port, port->ODR);
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *port, uint32_t pin)
+{
+    uint32_t idx = port_index(port);
+    s_out_mask[idx] &= (uint16_t) ~pin;
+    sim_exti.IMR &= ~pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *port, uint16_t pin)
+{
+    return (port->IDR & pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *port, uint16_t pin, GPIO_PinState state)
+{
+    uint32_t old = port->ODR;
+
+    if (state == GPIO_PIN_SET)
+        port->ODR |= pin;
+    else
+        port->ODR &= ~(uint32_t) pin;
+
+    uint16_t out = s_out_mask[port_index(port)];
+    port->IDR = (port->IDR & ~(uint32_t) out) | (port->ODR & out);
+    jam_on_gpio(port, old);
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *port, uint16_t pin)
+{
+    HAL_GPIO_WritePin(port, pin, (port->ODR & pin) ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t pin)
+{
+    if (sim_exti.PR & pin)
+    {
+        sim_exti.PR &= ~(uint32_t) pin;
+        HAL_GPIO_EXTI_Callback(pin);
+    }
+}
+
+void sim_gpio_input(GPIO_TypeDef *port, uint16_t pin, bool level)
+{
+    bool old = (port->IDR & pin) != 0;
+    if (old == level)
+        return;
+
+    if (level)
+        port->IDR |= pin;
+    else
+        port->IDR &= ~(uint32_t) pin;
+
+    uint32_t line = (uint32_t) __builtin_ctz(pin);
+    uint32_t shift = (line % 4u) * 4u;
+    bool routed = ((sim_afio.EXTICR[line / 4u] >> shift) & 0xFu) == port_index(port);
+    bool armed = (sim_exti.IMR & pin) && (level ? (sim_exti.RTSR & pin) : (sim_exti.FTSR & pin));
+    if (!routed || !armed)
+        return;
+
+    sim_exti.PR |= pin;
+
+    IRQn_Type irqn = exti_irqn(line);
+    void (*vec)(void) = exti_vector(irqn);
+    if (!s_nvic_on[irqn] || !vec || s_primask || s_active)
+        return;
+
+    run_vector(vec);
+
+    /* pr is write-1-to-clear on silicon; a plain struct cannot model that,
+ * so treat the line as serviced once its vector returns
+ */
+    sim_exti.PR &= ~(uint32_t) pin;
+    deliver_pending();
+}
+
+void sim_gpio_set(GPIO_TypeDef *port, uint16_t pin, bool level)
+{
+    if (level)
+        port->IDR |= pin;
+    else
+        port->IDR &= ~(uint32_t) pin;
+}
+
+/* ---- dma ------------------------------------------------------------------ */
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+    return hdma ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+    return hdma ? HAL_OK : HAL_ERROR;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+    (void) hdma;
+}
+
+/* ---- i2c ------------------------------------------------------------------ */
+
+static sim_i2c_stats_t s_i2c;
+
+sim_i2c_stats_t sim_i2c_stats(void)
+{
+    return s_i2c;
+}
+
+/* a frame after FIRST_FRAME continues the transaction with a repeated start */
+static bool s_i2c_open = false;
+
+/* software time from one transaction's stop to the next start */
+#ifndef SIM_I2C_GAP_NS
+#define SIM_I2C_GAP_NS 5000u
+#endif
+
+/* scl period in pclk1 cycles, as the hal computes the ccr value */
+static uint32_t s_scl_clk = 360u;
+static uint32_t s_scl_pclk = 36000000u;
+
+static void i2c_timing(const I2C_InitTypeDef *init)
+{
+    uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+    uint32_t hz = init->ClockSpeed ? init->ClockSpeed : 100000u;
+    uint32_t coeff = (hz <= 100000u) ? 2u : (init->DutyCycle == I2C_DUTYCYCLE_16_9) ? 25u : 3u;
+    uint32_t ccr = (pclk - 1u) / (hz * coeff) + 1u;
+
+    if (hz <= 100000u && ccr < 4u)
+        ccr = 4u;
+    s_scl_clk = coeff * ccr;
+    s_scl_pclk = pclk;
+    s_i2c.scl_hz = pclk / s_scl_clk;
+}
+
+/* a start (or repeated start), the address byte and len bytes; the stop and
+ * the gap to the next transaction when it ends here
+ */
+static void i2c_bus_time(uint16_t len, bool stop)
+{
+    uint64_t clocks = 1u + 9u * (1u + (uint64_t) len) + (stop ? 1u : 0u);
+    s_i2c.bus_ns += clocks * s_scl_clk * 1000000000u / s_scl_pclk + (stop ? SIM_I2C_GAP_NS : 0u);
+}
+
+/* stuck bus: armed by sim_i2c_jam(), on once a transfer hits it */
+#define JAM_SCL GPIO_PIN_6
+#define JAM_SDA GPIO_PIN_7
+
+static uint64_t s_jam_at_us = UINT64_MAX;
+static uint32_t s_jam_clocks = 0;
+static bool s_jammed = false;
+
+void sim_i2c_jam(uint64_t at_us, uint32_t clocks)
+{
+    s_jam_at_us = at_us;
+    s_jam_clocks = clocks;
+}
+
+/* a transfer start while jammed or hitting the jam: true with *st set (HAL_OK
+ * for the one that hangs: it never completes; HAL_BUSY after that)
+ */
+static bool jam_hit(HAL_StatusTypeDef *st)
+{
+    if (!s_jammed && sim_now_us() >= s_jam_at_us)
+    {
+        s_jammed = true;
+        s_jam_at_us = UINT64_MAX;
+        sim_i2c1.SR2 |= I2C_SR2_BUSY;
+        *st = HAL_OK;
+        return true;
+    }
+    if (s_jammed)
+    {
+        *st = HAL_BUSY;
+        return true;
+    }
+    return false;
+}
+
+/* scl rising edges driven by gpio count down the jam; sda reads low while on */
+static void jam_on_gpio(GPIO_TypeDef *port, uint32_t old_odr)
+{
+    if (!s_jammed || port != GPIOB)
+        return;
+
+    bool rise = !(old_odr & JAM_SCL) && (port->ODR & JAM_SCL) && (s_out_mask[1] & JAM_SCL);
+    if (rise && s_jam_clocks != 0u && --s_jam_clocks == 0u)
+    {
+        s_jammed = false;
+        sim_i2c1.SR2 &= ~I2C_SR2_BUSY;
+        return;
+    }
+    port->IDR &= ~(uint32_t) JAM_SDA;
+}
+
+/* one start..stop write; only the ssd1306 acks */
+static HAL_StatusTypeDef i2c_bus_write(uint16_t addr, const uint8_t *data, uint16_t len, bool stop)
+{
+    if (!s_i2c_open)
+        s_i2c.transactions++;
+    s_i2c.bytes += 1u + len;
+    i2c_bus_time(len, stop);
+
+    if ((addr >> 1) != SIM_SSD1306_ADDR7)
+        return HAL_ERROR;
+
+    sim_ssd1306_write(data, len);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+    if (!hi2c)
+        return HAL_ERROR;
+    hi2c->State = HAL_I2C_STATE_READY;
+    hi2c->ErrorCode = 0;
+    i2c_timing(&hi2c->Init);
+    if (hi2c->Instance == I2C1)
+        hi2c->Instance->SR2 = s_jammed ? I2C_SR2_BUSY : 0u;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+    if (!hi2c)
+        return HAL_ERROR;
+    hi2c->State = HAL_I2C_STATE_RESET;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c,
+                                          uint16_t addr,
+                                          uint8_t *data,
+                                          uint16_t len,
+                                          uint32_t timeout)
+{
+    (void) timeout;
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+
+    /* a blocking call on a jammed bus runs into its timeout */
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return (jst == HAL_OK) ? HAL_TIMEOUT : jst;
+    return i2c_bus_write(addr, data, len, true);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c,
+                                         uint16_t addr,
+                                         uint8_t *data,
+                                         uint16_t len,
+                                         uint32_t timeout)
+{
+    (void) timeout;
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return (jst == HAL_OK) ? HAL_TIMEOUT : jst;
+
+    s_i2c.transactions++;
+    s_i2c.bytes += 1u + len;
+    i2c_bus_time(len, true);
+    memset(data, 0, len);
+    return ((addr >> 1) == SIM_SSD1306_ADDR7) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c,
+                                        uint16_t addr,
+                                        uint32_t trials,
+                                        uint32_t timeout)
+{
+    (void) trials;
+    (void) timeout;
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return (jst == HAL_OK) ? HAL_TIMEOUT : jst;
+    return ((addr >> 1) == SIM_SSD1306_ADDR7) ? HAL_OK : HAL_ERROR;
+}
+
+/* the transfer completes at once; the completion callback runs as an isr */
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c,
+                                              uint16_t addr,
+                                              uint8_t *data,
+                                              uint16_t len)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return jst;
+
+    HAL_StatusTypeDef st = i2c_bus_write(addr, data, len, true);
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (st == HAL_OK)
+        HAL_I2C_MasterTxCpltCallback(hi2c);
+    else
+        HAL_I2C_ErrorCallback(hi2c);
+    __set_PRIMASK(primask);
+
+    return HAL_OK;
+}
+
+/* report an interrupt-driven transfer as its isr would */
+static void i2c_irq_done(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef st, bool rx)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (st != HAL_OK)
+        HAL_I2C_ErrorCallback(hi2c);
+    else if (rx)
+        HAL_I2C_MasterRxCpltCallback(hi2c);
+    else
+        HAL_I2C_MasterTxCpltCallback(hi2c);
+    __set_PRIMASK(primask);
+}
+
+static HAL_StatusTypeDef i2c_bus_read(uint16_t addr, uint8_t *data, uint16_t len, bool stop)
+{
+    if (!s_i2c_open)
+        s_i2c.transactions++;
+    s_i2c.bytes += 1u + len;
+    i2c_bus_time(len, stop);
+    memset(data, 0, len);
+    return ((addr >> 1) == SIM_SSD1306_ADDR7) ? HAL_OK : HAL_ERROR;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c,
+                                             uint16_t addr,
+                                             uint8_t *data,
+                                             uint16_t len)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return jst;
+    i2c_irq_done(hi2c, i2c_bus_write(addr, data, len, true), false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive_IT(I2C_HandleTypeDef *hi2c,
+                                            uint16_t addr,
+                                            uint8_t *data,
+                                            uint16_t len)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return jst;
+    i2c_irq_done(hi2c, i2c_bus_read(addr, data, len, true), true);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Transmit_IT(I2C_HandleTypeDef *hi2c,
+                                                 uint16_t addr,
+                                                 uint8_t *data,
+                                                 uint16_t len,
+                                                 uint32_t options)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return jst;
+    HAL_StatusTypeDef st = i2c_bus_write(addr, data, len, options != I2C_FIRST_FRAME);
+    s_i2c_open = (st == HAL_OK) && (options == I2C_FIRST_FRAME);
+    i2c_irq_done(hi2c, st, false);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Seq_Receive_IT(I2C_HandleTypeDef *hi2c,
+                                                uint16_t addr,
+                                                uint8_t *data,
+                                                uint16_t len,
+                                                uint32_t options)
+{
+    if (hi2c->State != HAL_I2C_STATE_READY)
+        return HAL_BUSY;
+    HAL_StatusTypeDef jst;
+    if (jam_hit(&jst))
+        return jst;
+    HAL_StatusTypeDef st = i2c_bus_read(addr, data, len, options != I2C_FIRST_FRAME);
+    s_i2c_open = (st == HAL_OK) && (options == I2C_FIRST_FRAME);
+    i2c_irq_done(hi2c, st, true);
+    return HAL_OK;
+}
+
+/* nothing to abort: transfers finish at once, and a jammed one only ends by
+ * bus recovery
+ */
+HAL_StatusTypeDef HAL_I2C_Master_Abort_IT(I2C_HandleTypeDef *hi2c, uint16_t addr)
+{
+    (void) hi2c;
+    (void) addr;
+    return HAL_ERROR;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c)
+{
+    return hi2c->State;
+}
+
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+/* weak defaults, as in the hal */
+__attribute__((weak)) void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__attribute__((weak)) void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__attribute__((weak)) void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+__attribute__((weak)) void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void) hi2c;
+}
+
+/* ---- flash ---------------------------------------------------------------- */
+
+#define SIM_FLASH_SIZE (64u * 1024u)
+
+/* f103 datasheet typicals */
+#define SIM_FLASH_PROG_US 52u
+#define SIM_FLASH_ERASE_US 20000u
+
+static uint8_t s_flash[SIM_FLASH_SIZE];
+static bool s_flash_erased = false;
+static bool s_flash_locked = true;
+static sim_flash_stats_t s_flash_stats;
+
+static uint32_t s_flash_ops = 0;
+static uint32_t s_cut_op = 0;
+static void (*s_on_cut)(void) = NULL;
+
+static uint8_t *flash_at(uint32_t addr, uint32_t len)
+{
+    if (!s_flash_erased)
+    {
+        memset(s_flash, 0xFF, sizeof(s_flash));
+        s_flash_erased = true;
+    }
+    if (addr < FLASH_BASE || addr - FLASH_BASE + len > SIM_FLASH_SIZE)
+        return NULL;
+    return &s_flash[addr - FLASH_BASE];
+}
+
+const uint8_t *sim_flash_ptr(uint32_t addr)
+{
+    const uint8_t *p = flash_at(addr, 1u);
+    if (!p)
+    {
+        fprintf(stderr, "sim: flash read outside the part at 0x%08x\n", (unsigned) addr);
+        abort();
+    }
+    return p;
+}
+
+sim_flash_stats_t sim_flash_stats(void)
+{
+    return s_flash_stats;
+}
+
+bool sim_flash_load(const char *path)
+{
+    (void) flash_at(FLASH_BASE, 0u);
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return true;
+    size_t n = fread(s_flash, 1, sizeof(s_flash), f);
+    fclose(f);
+    return n == sizeof(s_flash);
+}
+
+bool sim_flash_save(const char *path)
+{
+    (void) flash_at(FLASH_BASE, 0u);
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        return false;
+    size_t n = fwrite(s_flash, 1, sizeof(s_flash), f);
+    return (fclose(f) == 0) && n == sizeof(s_flash);
+}
+
+void sim_flash_cut(uint32_t nth, void (*on_cut)(void))
+{
+    s_cut_op = nth;
+    s_on_cut = on_cut;
+}
+
+/* the core waits for the flash: no vector runs, input edges only latch */
+static void flash_stall(uint32_t us)
+{
+    size_t before = s_inputs_next;
+    uint32_t primask = s_primask;
+    s_primask = 1;
+    sim_advance_to_us(s_now_us + us);
+    s_primask = primask;
+
+    s_flash_stats.stall_us += us;
+    s_flash_stats.late_edges += (uint32_t) (s_inputs_next - before);
+    if (!primask)
+        deliver_pending();
+}
+
+/* power fails during the next operation */
+static bool flash_cut_due(void)
+{
+    return s_on_cut && s_flash_ops + 1u == s_cut_op;
+}
+
+/* the caller has left the operation half done */
+static void __attribute__((noreturn)) flash_cut(void)
+{
+    s_on_cut();
+    exit(0);
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+    s_flash_locked = false;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+    s_flash_locked = true;
+    return HAL_OK;
+}
+
+/* halfwords only; as on silicon a halfword that is not erased takes only 0 */
+HAL_StatusTypeDef HAL_FLASH_Program(uint32_t type, uint32_t addr, uint64_t data)
+{
+    uint8_t *p = flash_at(addr, 2u);
+    if (s_flash_locked || type != FLASH_TYPEPROGRAM_HALFWORD || !p || (addr & 1u))
+        return HAL_ERROR;
+
+    uint16_t old = (uint16_t) (p[0] | (p[1] << 8));
+    uint16_t hw = (uint16_t) data;
+    if (old != 0xFFFFu && hw != 0u)
+        return HAL_ERROR;
+
+    if (flash_cut_due())
+    {
+        p[0] &= (uint8_t) hw;
+        flash_stall(SIM_FLASH_PROG_US / 2u);
+        flash_cut();
+    }
+    s_flash_ops++;
+
+    p[0] = (uint8_t) hw;
+    p[1] = (uint8_t) (hw >> 8);
+    s_flash_stats.programs++;
+    flash_stall(SIM_FLASH_PROG_US);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *init, uint32_t *page_error)
+{
+    if (s_flash_locked || !init || !page_error || init->TypeErase != FLASH_TYPEERASE_PAGES)
+        return HAL_ERROR;
+
+    for (uint32_t i = 0; i < init->NbPages; i++)
+    {
+        uint32_t addr = init->PageAddress + i * FLASH_PAGE_SIZE;
+        uint8_t *p = flash_at(addr, FLASH_PAGE_SIZE);
+        if (!p || (addr % FLASH_PAGE_SIZE) != 0u)
+        {
+            *page_error = addr;
+            return HAL_ERROR;
+        }
+
+        if (flash_cut_due())
+        {
+            memset(p, 0xFF, FLASH_PAGE_SIZE / 2u);
+            flash_stall(SIM_FLASH_ERASE_US / 2u);
+            flash_cut();
+        }
+        s_flash_ops++;
+
+        memset(p, 0xFF, FLASH_PAGE_SIZE);
+        s_flash_stats.erases++;
+        flash_stall(SIM_FLASH_ERASE_US);
+    }
+    *page_error = 0xFFFFFFFFu;
+    return HAL_OK;
+}
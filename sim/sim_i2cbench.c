@@ -0,0 +1,190 @@
+/* sprout_i2cbench: display throughput per i2c / transport configuration
+ * comments are lowercase
+ *
+ * boots the firmware's drivers (system_init(): clock, i2c1, display), then
+ * for every bus setting x display transport profile drives two workloads
+ * through the real display path and reads the bus model of the fake hal:
+ * - frame: full-screen redraws where every tile changes
+ * - counts: the count screen with the total going up by one
+ * bus time comes from the fake hal's model (sim.h). the frame rate is given
+ * as effective throughput: gddram bytes (512 per frame) per second of bus
+ * time; the count screen as updates per second.
+ *
+ * fails (exit 1) when a count update that changes one digit puts 10% or more
+ * of a full frame's bytes on the wire, for any transport profile.
+ *
+ * usage: sprout_i2cbench [-f frames] [-u updates]
+ */
+
+#include "sim.h"
+#include "system.h"
+#include "drivers/display/display.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct
+{
+    const char *name;
+    uint32_t hz;
+    i2c_duty_t duty;
+} bus_setting_t;
+
+typedef struct
+{
+    const char *name;
+    display_tx_profile_t prof;
+} tx_setting_t;
+
+/* 16:9 at 480 khz is past the 400 khz fast-mode limit: shown as a bound */
+static const bus_setting_t s_buses[] = {
+    {"100k", 100000u, I2C_DUTY_2},
+    {"400k 2:1", 400000u, I2C_DUTY_2},
+    {"400k 16:9", 400000u, I2C_DUTY_16_9},
+    {"480k 16:9", 480000u, I2C_DUTY_16_9},
+};
+
+static const tx_setting_t s_txs[] = {
+    {"u8g2 chunks", {1u, false}},
+    {"join 64", {64u, false}},
+    {"join all", {0u, false}},
+    {"join+stream", {0u, true}},
+};
+
+/* every byte of the buffer differs from the previous frame */
+static void draw_fill(u8g2_t *u8g2, void *ctx)
+{
+    uint8_t v = *(const uint8_t *) ctx;
+    uint8_t *buf = u8g2_GetBufferPtr(u8g2);
+    uint32_t n = (uint32_t) u8g2_GetBufferTileHeight(u8g2) * u8g2_GetBufferTileWidth(u8g2) * 8u;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        buf[i] = (uint8_t) (v + i);
+    }
+}
+
+typedef struct
+{
+    uint32_t transactions;
+    uint32_t bytes;
+    uint64_t bus_ns;
+} sample_t;
+
+static sample_t since(const sim_i2c_stats_t *a)
+{
+    sim_i2c_stats_t b = sim_i2c_stats();
+    sample_t s = {b.transactions - a->transactions, b.bytes - a->bytes, b.bus_ns - a->bus_ns};
+    return s;
+}
+
+/* per item: transactions, bytes, bus us; returns the bus us */
+static double print_sample(const sample_t *s, uint32_t n)
+{
+    double us = (double) s->bus_ns / 1e3 / n;
+    printf("  %5.1f %5.0f %7.0f", (double) s->transactions / n, (double) s->bytes / n, us);
+    return us;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t frames = 20;
+    uint32_t updates = 200;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "f:u:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'f':
+                frames = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'u':
+                updates = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-f frames] [-u updates]\n", argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if (frames == 0u || updates == 0u)
+        return 2;
+
+    system_init();
+    i2c_bus_t *bus = system_i2c1();
+    if (!bus || !display_u8g2())
+    {
+        fprintf(stderr, "display init failed\n");
+        return 1;
+    }
+
+    printf("per frame / update: transactions, bytes, bus us; gddram kB/s, updates/s\n");
+    printf("%-10s %-12s %4s  %-27s  %s\n", "bus", "transport", "scl", "frame", "counts");
+
+    uint32_t total = 0;
+    uint8_t fill = 0;
+    uint32_t failed = 0;
+    for (size_t b = 0; b < sizeof(s_buses) / sizeof(s_buses[0]); b++)
+    {
+        i2c_config_t cfg = bus->cfg;
+        cfg.clock_speed_hz = s_buses[b].hz;
+        cfg.duty = s_buses[b].duty;
+        if (i2c_init(bus, &cfg) != I2C_ST_OK)
+        {
+            fprintf(stderr, "i2c_init failed\n");
+            return 1;
+        }
+
+        for (size_t t = 0; t < sizeof(s_txs) / sizeof(s_txs[0]); t++)
+        {
+            display_set_tx_profile(&s_txs[t].prof);
+            printf("%-10s %-12s %4u",
+                   s_buses[b].name,
+                   s_txs[t].name,
+                   (unsigned) (sim_i2c_stats().scl_hz / 1000u));
+
+            sim_i2c_stats_t t0 = sim_i2c_stats();
+            for (uint32_t i = 0; i < frames; i++)
+            {
+                fill = (uint8_t) (fill + 1u);
+                display_render(draw_fill, &fill);
+            }
+            sample_t s = since(&t0);
+            printf(" %6.1f", 512.0 / print_sample(&s, frames) * 1e3);
+
+            uint32_t frame_bytes = s.bytes / frames;
+
+            /* the first count screen clears the panel: not measured */
+            uint32_t counts[1] = {0};
+            display_show_counts(counts, 1, total++, 0);
+            t0 = sim_i2c_stats();
+            uint32_t digit_max = 0;
+            for (uint32_t i = 0; i < updates; i++)
+            {
+                sim_i2c_stats_t u0 = sim_i2c_stats();
+                uint32_t value = total++;
+                display_show_counts(counts, 1, value, 0);
+
+                /* only the last digit changed */
+                uint32_t bytes = sim_i2c_stats().bytes - u0.bytes;
+                if (value % 10u != 0u && bytes > digit_max)
+                    digit_max = bytes;
+            }
+            s = since(&t0);
+            printf(" %6.0f\n", 1e6 / print_sample(&s, updates));
+
+            /* a one-digit count update must cost under a tenth of a full frame */
+            if (digit_max * 10u >= frame_bytes)
+            {
+                printf("  one-digit update: %u bytes, full frame: %u bytes\n",
+                       (unsigned) digit_max,
+                       (unsigned) frame_bytes);
+                failed++;
+            }
+        }
+    }
+
+    printf("check: one-digit count update below 10%% of a full frame's bytes: %s\n",
+           failed ? "FAIL" : "ok");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,422 @@
+/* sprout_sim: runs the unmodified firmware on the fake hal
+ * comments are lowercase
+ *
+ * a scenario of beam breaks is scheduled on the ir channel pins, then the firmware's
+ * main() runs until the inputs are used up; at the end the counters, i2c
+ * traffic and the decoded panel are printed.
+ *
+ * usage: sprout_sim [-n pulses] [-p period_us] [-w width_us] [-b bounces]
+ *                   [-g bounce_gap_us] [-c channel_mask] [-a] [-D n] [-S n]
+ *                   [-P pause_us] [-j t_us[,clocks]] [-F flash.bin] [-x n]
+ *                   [-o panel.pbm] [-t trace.bin]
+ *
+ * -a breaks all channels at the same instant instead of staggering them inside
+ * the period; the coincidence window then counts each instant as one object.
+ *
+ * -D n makes every n-th seedling break the beam twice (a second, half as wide
+ * break width_us / 2 after the first one ends); -S n drops every n-th seedling
+ * (a missed planting). the report compares the raw and corrected counts with
+ * the known number of edges and seedlings, and the run fails when a
+ * corrected count is more than SIM_CORRECTED_TOL off.
+ *
+ * -P stops the line for pause_us before the last seedling (past 2^31 us the
+ * gap no longer fits the signed 32-bit timestamp math); the run fails if a
+ * learned mean gap (ir_get_filter()) ends up above SIM_GAP_AVG_MAX periods.
+ *
+ * -j jams the i2c bus at virtual time t_us: the transfer on the wire hangs
+ * with sda held low until `clocks` (default 3) scl pulses of the recovery;
+ * more than 9 make the first recoveries fail. the counts must not notice.
+ *
+ * -F keeps the flash in a file: loaded at start (a missing file is erased
+ * flash) and saved at the end, so the next run boots with the counts the
+ * last one left in the journal. the run then lasts STORE_MIN_MS longer, so
+ * the checkpoint taken once the counts pause is in it. -x n cuts the power during the nth flash
+ * program or erase: the run reports and saves the image right there.
+ *
+ * -t records the raw edges seen by ir_process() in the ir_trace format, ready
+ * for sprout_replay.
+ *
+ * a run that reaches its end checks what it must show ("check:" lines) and
+ * exits 1 if any failed; ctest runs the scenarios in sim/CMakeLists.txt.
+ */
+
+#include "sim.h"
+#include "system.h"
+#include "drivers/ir/ir.h"
+#include "sched/sched.h"
+#include "drivers/prof/prof.h"
+#include "drivers/display/display_gov.h"
+#include "drivers/store/store.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* src/main.c is built with main renamed */
+int firmware_main(void);
+
+/* scenario starts once boot (clock, display init) is well over */
+#define SIM_START_US 500000u
+#define SIM_SETTLE_US 100000u
+
+/* -D/-S: corrected counts may be off by this many seedlings per channel. the
+ * classifier does not judge breaks inside its first three gaps, and a skip
+ * after the last break cannot be seen
+ */
+#define SIM_CORRECTED_TOL 3u
+
+/* -P: learned mean gap after the pause, in planting periods */
+#define SIM_GAP_AVG_MAX 2u
+
+static const char *s_pbm_path = NULL;
+static const char *s_flash_path = NULL;
+static uint32_t s_expected[ir_count];
+static uint32_t s_seedlings[ir_count];
+static uint32_t s_objects = 0;
+static bool s_classify = false; /* -D or -S given */
+static uint64_t s_pause_us = 0;  /* -P */
+static uint32_t s_period_us = 0;
+static FILE *s_trace = NULL;
+
+static void trace_to_file(const uint8_t *data, uint32_t len, void *ctx)
+{
+    (void) fwrite(data, 1, len, (FILE *) ctx);
+}
+
+#if PROF_ENABLE
+static void print_line(const char *s, void *ctx)
+{
+    printf("  %s\n", s);
+}
+#endif
+
+static void report(void)
+{
+    printf("virtual time: %.3f s\n", (double) sim_now_us() / 1e6);
+
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        ir_filter_info_t fi;
+        (void) ir_get_filter((ir_id_t) ch, &fi);
+        printf("ir%u: count %u (injected %u), rejected %u, glitches %u, dead %u us, min width %u us%s\n",
+               (unsigned) ch,
+               (unsigned) ir_get_count((ir_id_t) ch),
+               (unsigned) s_expected[ch],
+               (unsigned) ir_get_rejected((ir_id_t) ch),
+               (unsigned) ir_get_glitches((ir_id_t) ch),
+               (unsigned) fi.dead_us,
+               (unsigned) fi.min_width_us,
+               fi.learned ? "" : " (default)");
+
+        ir_spacing_info_t sp;
+        (void) ir_get_spacing((ir_id_t) ch, &sp);
+        printf("ir%u: corrected %u (seedlings %u), doubles %u, missed %u, spacing %u us, merged %u\n",
+               (unsigned) ch,
+               (unsigned) ir_get_corrected((ir_id_t) ch),
+               (unsigned) s_seedlings[ch],
+               (unsigned) sp.doubles,
+               (unsigned) sp.missed,
+               (unsigned) sp.expected_us,
+               (unsigned) ir_get_merged((ir_id_t) ch));
+
+        ir_stats_info_t si;
+        (void) ir_get_stats((ir_id_t) ch, &si);
+        printf("ir%u: rate %u.%03u/s, gap avg %u us, window: %u gaps, min %u us, max %u us\n",
+               (unsigned) ch,
+               (unsigned) (si.rate_mhz / 1000u),
+               (unsigned) (si.rate_mhz % 1000u),
+               (unsigned) si.gap_avg_us,
+               (unsigned) si.window.gaps,
+               (unsigned) si.window.gap_min_us,
+               (unsigned) si.window.gap_max_us);
+    }
+    printf("total: %u, objects: %u (injected %u), overflows: %u\n",
+           (unsigned) ir_get_total(),
+           (unsigned) ir_get_objects(),
+           (unsigned) s_objects,
+           (unsigned) ir_get_overflows());
+
+    sched_stats_t st;
+    for (sched_id_t id = 0; sched_get_stats(id, &st); id++)
+    {
+        printf("task %s: %u runs (%u signaled), %u late, wcet %u cycles\n",
+               st.name,
+               (unsigned) st.runs,
+               (unsigned) st.signaled,
+               (unsigned) st.late,
+               (unsigned) st.wcet_cyc);
+    }
+
+#if PROF_ENABLE
+    printf("probes (host ns, min/avg/max):\n");
+    prof_dump(print_line, NULL);
+#endif
+
+    display_gov_stats_t gov = display_gov_get_stats();
+    printf("display: %u changes, %u frames (%u urgent), %u coalesced, %u dropped\n",
+           (unsigned) gov.changes,
+           (unsigned) gov.frames,
+           (unsigned) gov.urgent,
+           (unsigned) gov.coalesced,
+           (unsigned) gov.dropped);
+
+    sim_i2c_stats_t i2c = sim_i2c_stats();
+    i2c_recovery_stats_t rec = i2c_get_recovery(system_i2c1());
+    printf("i2c: %u transactions, %u bytes; %u stuck, %u recovered, %u failed\n",
+           (unsigned) i2c.transactions,
+           (unsigned) i2c.bytes,
+           (unsigned) rec.stuck,
+           (unsigned) rec.recovered,
+           (unsigned) rec.failed);
+
+    store_stats_t sto = store_get_stats();
+    sim_flash_stats_t fl = sim_flash_stats();
+    printf("store: restored #%u, %u checkpoints (%u waited), %u erases (%u held), %u torn, %u errors\n",
+           (unsigned) sto.restored,
+           (unsigned) sto.written,
+           (unsigned) sto.waits,
+           (unsigned) sto.journal.erases,
+           (unsigned) sto.erase_held,
+           (unsigned) sto.journal.torn,
+           (unsigned) sto.journal.errors);
+    printf("flash: %u halfwords, %u erases, %.1f ms stalled, %u inputs late\n",
+           (unsigned) fl.programs,
+           (unsigned) fl.erases,
+           (double) fl.stall_us / 1e3,
+           (unsigned) fl.late_edges);
+
+    sim_ssd1306_dump(stdout);
+    if (s_flash_path && !sim_flash_save(s_flash_path))
+    {
+        fprintf(stderr, "cannot write %s\n", s_flash_path);
+    }
+    if (s_pbm_path && !sim_ssd1306_save_pbm(s_pbm_path))
+    {
+        fprintf(stderr, "cannot write %s\n", s_pbm_path);
+    }
+    if (s_trace)
+    {
+        ir_trace_attach(NULL, NULL);
+        fclose(s_trace);
+    }
+    fflush(stdout);
+}
+
+static uint32_t s_failed = 0;
+
+static void check(bool ok, const char *what)
+{
+    printf("check: %s: %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok)
+        s_failed++;
+}
+
+/* pass/fail on what a complete run must show; the exit status is the verdict */
+static void finish(void)
+{
+    report();
+
+    /* the capture hook wakes the ir task: some runs must come from a signal */
+    sched_stats_t st;
+    for (sched_id_t id = 0; sched_get_stats(id, &st); id++)
+    {
+        if (strcmp(st.name, "ir") == 0 && ir_get_total() != 0u)
+            check(st.signaled != 0u, "ir task woken by ir_on_pending()");
+    }
+
+    /* doubles and skips: the corrected count is the number of seedlings,
+     * unless the run went on from counts restored from flash
+     */
+    if (s_classify && store_get_stats().restored == 0u)
+    {
+        for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+        {
+            uint32_t corr = ir_get_corrected((ir_id_t) ch);
+            uint32_t off = (corr > s_seedlings[ch]) ? corr - s_seedlings[ch] : s_seedlings[ch] - corr;
+            char what[64];
+            snprintf(what, sizeof(what), "ir%u corrected within %u of the seedlings",
+                     (unsigned) ch, (unsigned) SIM_CORRECTED_TOL);
+            check(off <= SIM_CORRECTED_TOL, what);
+        }
+    }
+
+    /* a long stop must not blow up the filter's mean gap */
+    if (s_pause_us != 0u)
+    {
+        for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+        {
+            ir_filter_info_t fi;
+            if (s_expected[ch] == 0u || !ir_get_filter((ir_id_t) ch, &fi))
+                continue;
+            char what[64];
+            snprintf(what, sizeof(what), "ir%u mean gap %u us within %u periods",
+                     (unsigned) ch, (unsigned) fi.gap_avg_us, (unsigned) SIM_GAP_AVG_MAX);
+            check(fi.gap_avg_us <= (uint64_t) SIM_GAP_AVG_MAX * s_period_us, what);
+        }
+    }
+
+    fflush(stdout);
+    exit(s_failed ? 1 : 0);
+}
+
+static void power_cut(void)
+{
+    printf("power cut during flash operation\n");
+    report();
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t pulses = 100;
+    uint32_t period_us = 20000;
+    uint32_t width_us = 5000;
+    uint32_t bounces = 0;
+    uint32_t bounce_gap_us = 200;
+    uint32_t mask = (1u << ir_count) - 1u;
+    bool aligned = false;
+    uint32_t double_every = 0;
+    uint32_t skip_every = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:p:w:b:g:c:aD:S:P:j:F:x:o:t:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                pulses = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'p':
+                period_us = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                width_us = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'b':
+                bounces = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'g':
+                bounce_gap_us = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'c':
+                mask = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'a':
+                aligned = true;
+                break;
+            case 'D':
+                double_every = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'S':
+                skip_every = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'P':
+                s_pause_us = strtoull(optarg, NULL, 0);
+                break;
+            case 'j':
+            {
+                char *end = NULL;
+                uint64_t at = strtoull(optarg, &end, 0);
+                uint32_t clocks = (end && *end == ',') ? (uint32_t) strtoul(end + 1, NULL, 0) : 3u;
+                sim_i2c_jam(at, clocks);
+                break;
+            }
+            case 'F':
+                s_flash_path = optarg;
+                if (!sim_flash_load(optarg))
+                {
+                    fprintf(stderr, "cannot read %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'x':
+                sim_flash_cut((uint32_t) strtoul(optarg, NULL, 0), power_cut);
+                break;
+            case 'o':
+                s_pbm_path = optarg;
+                break;
+            case 't':
+                s_trace = fopen(optarg, "wb");
+                if (!s_trace)
+                {
+                    fprintf(stderr, "cannot write %s\n", optarg);
+                    return 1;
+                }
+                ir_trace_attach(trace_to_file, s_trace);
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n pulses] [-p period_us] [-w width_us] [-b bounces]\n"
+                        "          [-g bounce_gap_us] [-c channel_mask] [-a] [-D n] [-S n]\n"
+                        "          [-P pause_us] [-j t_us[,clocks]] [-F flash.bin] [-x n]\n"
+                        "          [-o panel.pbm] [-t trace.bin]\n",
+                        argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    s_period_us = period_us;
+
+    /* beam break = low; channels are staggered inside the period */
+    uint64_t last = SIM_START_US;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        if (!(mask & (1u << ch)))
+            continue;
+
+        GPIO_TypeDef *port = ir_get_port((ir_id_t) ch);
+        uint16_t pin = ir_get_pin((ir_id_t) ch);
+        uint64_t offset = aligned ? 0u : (uint64_t) period_us * ch / ir_count;
+        uint32_t edges = 0;
+        for (uint32_t k = 0; k < pulses; k++)
+        {
+            uint64_t t = SIM_START_US + offset + (uint64_t) k * period_us;
+            if (k + 1u == pulses)
+                t += s_pause_us;
+
+            if (skip_every != 0u && (k + 1u) % skip_every == 0u)
+                continue;
+            edges++;
+
+            /* each bounce is a short release + re-break after the first edge */
+            (void) sim_schedule_input(t, port, pin, false);
+            for (uint32_t b = 0; b < bounces; b++)
+            {
+                uint64_t tb = t + (uint64_t) (b + 1u) * bounce_gap_us;
+                (void) sim_schedule_input(tb, port, pin, true);
+                (void) sim_schedule_input(tb + bounce_gap_us / 2u, port, pin, false);
+            }
+            (void) sim_schedule_input(t + width_us, port, pin, true);
+
+            uint64_t end = t + width_us;
+            if (double_every != 0u && (k + 1u) % double_every == 0u)
+            {
+                uint64_t t2 = end + width_us / 2u;
+                (void) sim_schedule_input(t2, port, pin, false);
+                (void) sim_schedule_input(t2 + width_us / 2u, port, pin, true);
+                end = t2 + width_us / 2u;
+                edges++;
+            }
+
+            if (end > last)
+                last = end;
+        }
+        s_expected[ch] = edges;
+        s_seedlings[ch] = pulses;
+        s_classify = double_every != 0u || skip_every != 0u;
+
+        /* aligned breaks are one object per instant (coincidence window) */
+        if (!aligned)
+            s_objects += edges;
+        else if (edges > s_objects)
+            s_objects = edges;
+    }
+
+    /* with a flash file, run on until the pause checkpoint of the last counts
+     * is written, so the next run boots with them
+     */
+    if (s_flash_path)
+        last += (uint64_t) STORE_MIN_MS * 1000u;
+
+    sim_set_end(last + SIM_SETTLE_US, finish);
+    return firmware_main();
+}
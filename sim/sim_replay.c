@@ -0,0 +1,226 @@
+/* sprout_replay: feeds a recorded ir_trace through the firmware's ir path
+ * comments are lowercase
+ *
+ * every edge is replayed on the fake hal at its (optionally compressed)
+ * virtual time: the pin level is set and gpio_on_interrupt() runs as the exti
+ * isr would, then ir_process() drains the ring like the main loop. at the end
+ * the counts, debounce rejections and host ns/event are printed.
+ *
+ * run the same trace against builds with different IR_DEBOUNCE_US to check
+ * that a debounce change keeps real-world counts; raise -s and -q to stress
+ * the isr ring.
+ *
+ * usage: sprout_replay [-s speedup] [-q batch] [-r repeat] trace.bin
+ *   -s  divide trace time by this factor (default 1 = real time)
+ *   -q  edges queued per ir_process() call (default 1: main loop wakes per edge)
+ *   -r  replay the trace this many times (for stable timings)
+ */
+
+#include "sim.h"
+#include "system.h"
+#include "drivers/ir/ir.h"
+#include "drivers/ir/ir_trace.h"
+#include "drivers/gpio/gpio.h"
+#include "drivers/timebase/timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/* lead-in and gap between repeats, well past any debounce window */
+#define REPLAY_GAP_US 1000000u
+
+static uint8_t *load(const char *path, uint32_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+        return NULL;
+
+    uint8_t *buf = NULL;
+    size_t cap = 0, n = 0;
+    for (;;)
+    {
+        if (n == cap)
+        {
+            cap = cap ? cap * 2u : 65536u;
+            uint8_t *p = realloc(buf, cap);
+            if (!p)
+            {
+                free(buf);
+                fclose(f);
+                return NULL;
+            }
+            buf = p;
+        }
+        size_t got = fread(buf + n, 1, cap - n, f);
+        if (got == 0)
+            break;
+        n += got;
+    }
+    fclose(f);
+
+    *len = (uint32_t) n;
+    return buf;
+}
+
+static uint64_t host_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+    double speedup = 1.0;
+    uint32_t batch = 1;
+    uint32_t repeat = 1;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:q:r:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 's':
+                speedup = strtod(optarg, NULL);
+                break;
+            case 'q':
+                batch = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 'r':
+                repeat = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s speedup] [-q batch] [-r repeat] trace.bin\n", argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1 || speedup <= 0.0 || batch == 0u || repeat == 0u)
+    {
+        fprintf(stderr, "usage: %s [-s speedup] [-q batch] [-r repeat] trace.bin\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t len = 0;
+    uint8_t *trace = load(argv[optind], &len);
+    ir_trace_dec_t dec;
+    if (!trace || !ir_trace_dec_init(&dec, trace, len))
+    {
+        fprintf(stderr, "%s: not an ir trace\n", argv[optind]);
+        return 1;
+    }
+
+    /* only what the ir path needs: clock, timebase and the exti inputs */
+    HAL_Init();
+    system_clock_config();
+    timebase_init();
+    if (!ir_init())
+    {
+        fprintf(stderr, "ir_init failed\n");
+        return 1;
+    }
+
+    uint64_t edges = 0, ignored = 0, queued = 0;
+    uint64_t base_us = sim_now_us() + REPLAY_GAP_US;
+    uint64_t rel_us = 0;
+    bool truncated = false;
+
+    uint64_t t0 = host_ns();
+    for (uint32_t r = 0; r < repeat; r++)
+    {
+        (void) ir_trace_dec_init(&dec, trace, len);
+        uint32_t prev = dec.tick;
+        rel_us = 0;
+
+        ir_event_t e;
+        while (ir_trace_next(&dec, &e))
+        {
+            rel_us += (uint32_t) (e.tick - prev);
+            prev = e.tick;
+
+            if (e.channel >= (uint8_t) ir_count)
+            {
+                ignored++;
+                continue;
+            }
+
+            sim_advance_to_us(base_us + (uint64_t) ((double) rel_us / speedup));
+
+            uint16_t pin = ir_get_pin((ir_id_t) e.channel);
+            sim_gpio_set(ir_get_port((ir_id_t) e.channel), pin, e.level != 0u);
+            gpio_on_interrupt(pin);
+            edges++;
+
+            if (++queued == batch)
+            {
+                (void) ir_process();
+                queued = 0;
+            }
+        }
+        truncated = truncated || dec.truncated;
+
+        (void) ir_process();
+        queued = 0;
+        base_us = sim_now_us() + REPLAY_GAP_US;
+    }
+    uint64_t elapsed = host_ns() - t0;
+
+    printf("trace: %u bytes, %u channels, %.3f s, %llu edges x %u\n",
+           (unsigned) len,
+           (unsigned) dec.channels,
+           (double) rel_us / 1e6,
+           (unsigned long long) (edges / repeat),
+           (unsigned) repeat);
+    if (truncated)
+        printf("warning: trace ends inside a record\n");
+    if (ignored)
+        printf("ignored: %llu edges on channels >= %u\n",
+               (unsigned long long) ignored,
+               (unsigned) ir_count);
+
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        ir_filter_info_t fi;
+        (void) ir_get_filter((ir_id_t) ch, &fi);
+        printf("ir%u: count %u, rejected %u, glitches %u, dead %u us, min width %u us%s\n",
+               (unsigned) ch,
+               (unsigned) ir_get_count((ir_id_t) ch),
+               (unsigned) ir_get_rejected((ir_id_t) ch),
+               (unsigned) ir_get_glitches((ir_id_t) ch),
+               (unsigned) fi.dead_us,
+               (unsigned) fi.min_width_us,
+               fi.learned ? "" : " (default)");
+
+        ir_spacing_info_t sp;
+        (void) ir_get_spacing((ir_id_t) ch, &sp);
+        printf("ir%u: corrected %u, doubles %u, missed %u, spacing %u us, merged %u\n",
+               (unsigned) ch,
+               (unsigned) ir_get_corrected((ir_id_t) ch),
+               (unsigned) sp.doubles,
+               (unsigned) sp.missed,
+               (unsigned) sp.expected_us,
+               (unsigned) ir_get_merged((ir_id_t) ch));
+
+        ir_stats_info_t si;
+        (void) ir_get_stats((ir_id_t) ch, &si);
+        printf("ir%u: rate %u.%03u/s, gap avg %u us, window: %u gaps, min %u us, max %u us\n",
+               (unsigned) ch,
+               (unsigned) (si.rate_mhz / 1000u),
+               (unsigned) (si.rate_mhz % 1000u),
+               (unsigned) si.gap_avg_us,
+               (unsigned) si.window.gaps,
+               (unsigned) si.window.gap_min_us,
+               (unsigned) si.window.gap_max_us);
+    }
+    printf("total: %u, objects: %u, overflows: %u\n",
+           (unsigned) ir_get_total(),
+           (unsigned) ir_get_objects(),
+           (unsigned) ir_get_overflows());
+    printf("speedup %.1fx, batch %u: %.1f ns/event (host, incl. sim time advance)\n",
+           speedup,
+           (unsigned) batch,
+           edges ? (double) elapsed / (double) edges : 0.0);
+
+    free(trace);
+    return 0;
+}
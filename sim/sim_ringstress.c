@@ -0,0 +1,233 @@
+/* sprout_ringstress: the ir edge ring (ir_ring.h) under load
+ * comments are lowercase
+ *
+ * a producer plays the capture isr and pushes numbered records, mostly only
+ * when there is room but now and then in bursts that run into a full ring; a
+ * consumer plays the main loop and drains in passes of random length, so the
+ * ring runs empty, half full and full in turn. every record carries its
+ * number in tick and a check pattern in lines/levels.
+ *
+ * by default the two interleave on one thread at random, as the isr preempts
+ * the main loop on the f103, with the ring indices starting just below their
+ * 2^32 wrap. -t runs them on two threads instead, which on a multi-core
+ * host also exercises the memory ordering of push and pop.
+ *
+ * fails (exit 1) when the consumer sees a record twice, out of order or torn,
+ * when the numbers it missed are not exactly the pushes that were refused, or
+ * when ir_ring_overflows() differs from the refused pushes.
+ *
+ * usage: sprout_ringstress [-n events] [-s seed]
+ */
+
+#include "drivers/ir/ir_ring.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static ir_ring_t s_ring;
+static uint32_t s_events = 4000000u;
+static uint32_t s_seed = 1u;
+
+/* producer side */
+static uint32_t s_next = 1;  /* numbers start at 1: tick 0 is "nothing yet" */
+static uint32_t s_burst = 0; /* pushes left that do not wait for room */
+static uint32_t s_pushed = 0;
+static uint32_t s_refused = 0;
+static volatile uint32_t s_done = 0;
+
+/* consumer side */
+static uint32_t s_last = 0;
+static uint32_t s_popped = 0;
+static uint32_t s_missed = 0; /* numbers skipped between two pops */
+static uint32_t s_bad = 0;    /* duplicated, out of order or torn */
+
+static uint32_t xorshift(uint32_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 17;
+    *x ^= *x << 5;
+    return *x;
+}
+
+static inline uint16_t pattern_lines(uint32_t n)
+{
+    return (uint16_t) (n * 2654435761u >> 16);
+}
+
+static inline uint16_t pattern_levels(uint32_t n)
+{
+    return (uint16_t) ~pattern_lines(n);
+}
+
+/* one capture isr: false (nothing pushed) while it waits for room */
+static bool produce(uint32_t *rnd)
+{
+    /* edges mostly come slower than the main loop takes them; now and then
+     * a burst pushes on regardless and runs into a full ring
+     */
+    if (s_burst == 0u && (xorshift(rnd) & 63u) == 0u)
+        s_burst = (xorshift(rnd) & 127u) + 1u;
+    if (s_burst != 0u)
+        s_burst--;
+    else if (ir_ring_pending(&s_ring) >= IR_RING_SIZE)
+        return false;
+
+    uint32_t n = s_next++;
+    if (ir_ring_push(&s_ring, n, pattern_lines(n), pattern_levels(n)))
+        s_pushed++;
+    else
+        s_refused++;
+    if (n == s_events)
+        __atomic_store_n(&s_done, 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* one record for the main loop: false when the ring is empty */
+static bool consume(void)
+{
+    ir_edges_t e;
+    if (!ir_ring_pop(&s_ring, &e))
+        return false;
+
+    if (e.tick <= s_last || e.lines != pattern_lines(e.tick) ||
+        e.levels != pattern_levels(e.tick))
+    {
+        s_bad++;
+        return true;
+    }
+    s_missed += e.tick - s_last - 1u;
+    s_last = e.tick;
+    s_popped++;
+    return true;
+}
+
+/* single core: the isr preempts the main loop between any two of its steps;
+ * the indices start just below their 2^32 wrap
+ */
+static void run_interleaved(void)
+{
+    uint32_t rnd = s_seed * 2u + 1u;
+    s_ring.head = s_ring.tail = 0u - s_events / 2u;
+
+    while (s_next <= s_events)
+    {
+        /* a main loop pass takes a few records, the isrs in between a few edges */
+        uint32_t pops = xorshift(&rnd) & 7u;
+        while (pops-- && consume())
+        {
+        }
+        uint32_t pushes = xorshift(&rnd) & 7u;
+        while (pushes-- && s_next <= s_events && produce(&rnd))
+        {
+        }
+    }
+    while (consume())
+    {
+    }
+}
+
+static void *producer(void *arg)
+{
+    uint32_t rnd = s_seed * 2u + 1u;
+    while (s_next <= s_events)
+    {
+        if (!produce(&rnd))
+            (void) sched_yield();
+    }
+    return arg;
+}
+
+static void *consumer(void *arg)
+{
+    uint32_t rnd = s_seed * 2u + 3u;
+    for (;;)
+    {
+        /* the producer's last push is visible once done is */
+        bool done = __atomic_load_n(&s_done, __ATOMIC_ACQUIRE) != 0u;
+
+        /* a pass of the ir task: drain everything, or just a few records */
+        uint32_t pass = (xorshift(&rnd) & 1u) ? UINT32_MAX : (xorshift(&rnd) & 15u) + 1u;
+        while (pass-- && consume())
+        {
+        }
+        if (done && ir_ring_pending(&s_ring) == 0u)
+            break;
+        if (ir_ring_pending(&s_ring) == 0u)
+            (void) sched_yield();
+    }
+    return arg;
+}
+
+/* two cores: producer and consumer really run at the same time */
+static bool run_threads(void)
+{
+    pthread_t prod;
+    pthread_t cons;
+    if (pthread_create(&cons, NULL, consumer, NULL) != 0)
+        return false;
+    if (pthread_create(&prod, NULL, producer, NULL) != 0)
+    {
+        __atomic_store_n(&s_done, 1u, __ATOMIC_RELEASE);
+        (void) pthread_join(cons, NULL);
+        return false;
+    }
+    (void) pthread_join(prod, NULL);
+    (void) pthread_join(cons, NULL);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    bool threads = false;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:s:th")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n':
+                s_events = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                s_seed = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                threads = true;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n events] [-s seed] [-t]\n", argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    ir_ring_init(&s_ring);
+    if (!threads)
+        run_interleaved();
+    else if (!run_threads())
+    {
+        fprintf(stderr, "cannot start threads\n");
+        return 2;
+    }
+
+    /* pushes refused after the last record also went missing */
+    s_missed += s_events - s_last;
+
+    printf("ring: %u records, %u events (%s): %u pushed, %u refused, %u overflows counted\n",
+           (unsigned) IR_RING_SIZE,
+           (unsigned) s_events,
+           threads ? "threads" : "interleaved",
+           (unsigned) s_pushed,
+           (unsigned) s_refused,
+           (unsigned) ir_ring_overflows(&s_ring));
+    printf("consumer: %u popped, %u missed, %u bad\n",
+           (unsigned) s_popped,
+           (unsigned) s_missed,
+           (unsigned) s_bad);
+
+    bool ok = s_bad == 0u && s_popped == s_pushed && s_missed == s_refused &&
+              ir_ring_overflows(&s_ring) == s_refused && s_refused != 0u;
+    printf("check: no edge lost, duplicated or torn, overflows exact: %s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,222 @@
+/* ssd1306 model: decodes i2c writes into a 128x64 gddram image
+ * comments are lowercase
+ */
+
+#include "sim.h"
+#include <string.h>
+
+#define PANEL_W 128u
+#define PANEL_PAGES 8u
+#define PANEL_VISIBLE_PAGES 4u /* 128x32 glass */
+
+/* gddram plus the addressing state that decides where data lands */
+static uint8_t s_ram[PANEL_PAGES][PANEL_W];
+static uint8_t s_mode = 2; /* 0 horizontal, 1 vertical, 2 page (reset default) */
+static uint8_t s_col, s_page;
+static uint8_t s_col_lo = 0, s_col_hi = PANEL_W - 1u;
+static uint8_t s_page_lo = 0, s_page_hi = PANEL_PAGES - 1u;
+
+/* command decoder: pending opcode and how many argument bytes it still needs */
+static uint8_t s_cmd;
+static uint8_t s_args[8];
+static uint8_t s_nargs, s_want;
+
+static uint8_t cmd_arg_count(uint8_t c)
+{
+    switch (c)
+    {
+        case 0x20: /* memory addressing mode */
+        case 0x81: /* contrast */
+        case 0x8D: /* charge pump */
+        case 0xA8: /* multiplex ratio */
+        case 0xD3: /* display offset */
+        case 0xD5: /* clock divide */
+        case 0xD9: /* pre-charge */
+        case 0xDA: /* com pins */
+        case 0xDB: /* vcomh */
+            return 1;
+        case 0x21: /* column address range */
+        case 0x22: /* page address range */
+        case 0xA3: /* vertical scroll area */
+            return 2;
+        case 0x26: /* horizontal scroll setup */
+        case 0x27:
+            return 6;
+        case 0x29: /* vertical + horizontal scroll setup */
+        case 0x2A:
+            return 5;
+        default:
+            return 0;
+    }
+}
+
+static void cmd_exec(void)
+{
+    uint8_t c = s_cmd;
+
+    if (c <= 0x0F)
+    {
+        s_col = (uint8_t) ((s_col & 0xF0u) | c);
+    }
+    else if (c <= 0x1F)
+    {
+        s_col = (uint8_t) ((s_col & 0x0Fu) | ((c & 0x0Fu) << 4));
+    }
+    else if (c >= 0xB0 && c <= 0xB7)
+    {
+        s_page = (uint8_t) (c & 0x07u);
+    }
+    else if (c == 0x20)
+    {
+        s_mode = (uint8_t) (s_args[0] & 0x03u);
+    }
+    else if (c == 0x21)
+    {
+        s_col_lo = (uint8_t) (s_args[0] & 0x7Fu);
+        s_col_hi = (uint8_t) (s_args[1] & 0x7Fu);
+        s_col = s_col_lo;
+    }
+    else if (c == 0x22)
+    {
+        s_page_lo = (uint8_t) (s_args[0] & 0x07u);
+        s_page_hi = (uint8_t) (s_args[1] & 0x07u);
+        s_page = s_page_lo;
+    }
+    /* everything else (contrast, power, scroll, ...) does not move pixels */
+}
+
+static void cmd_byte(uint8_t b)
+{
+    if (s_want)
+    {
+        s_args[s_nargs++] = b;
+        if (--s_want == 0)
+            cmd_exec();
+        return;
+    }
+
+    s_cmd = b;
+    s_nargs = 0;
+    s_want = cmd_arg_count(b);
+    if (s_want == 0)
+        cmd_exec();
+}
+
+static void data_byte(uint8_t b)
+{
+    s_ram[s_page & 0x07u][s_col & 0x7Fu] = b;
+
+    switch (s_mode)
+    {
+        case 0: /* horizontal: column first, then page, both within the window */
+            if (s_col >= s_col_hi)
+            {
+                s_col = s_col_lo;
+                s_page = (s_page >= s_page_hi) ? s_page_lo : (uint8_t) (s_page + 1u);
+            }
+            else
+            {
+                s_col++;
+            }
+            break;
+        case 1: /* vertical: page first, then column */
+            if (s_page >= s_page_hi)
+            {
+                s_page = s_page_lo;
+                s_col = (s_col >= s_col_hi) ? s_col_lo : (uint8_t) (s_col + 1u);
+            }
+            else
+            {
+                s_page++;
+            }
+            break;
+        default: /* page mode: column wraps inside the page */
+            s_col = (uint8_t) ((s_col + 1u) & 0x7Fu);
+            break;
+    }
+}
+
+void sim_ssd1306_write(const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+
+    /* control byte: bit7 co (one byte then another control), bit6 d/c */
+    while (i < len)
+    {
+        uint8_t ctrl = data[i++];
+        bool is_data = (ctrl & 0x40u) != 0;
+        bool single = (ctrl & 0x80u) != 0;
+
+        if (single)
+        {
+            if (i < len)
+            {
+                if (is_data)
+                    data_byte(data[i]);
+                else
+                    cmd_byte(data[i]);
+                i++;
+            }
+            continue;
+        }
+
+        for (; i < len; i++)
+        {
+            if (is_data)
+                data_byte(data[i]);
+            else
+                cmd_byte(data[i]);
+        }
+    }
+}
+
+static bool pixel(uint32_t x, uint32_t y)
+{
+    return (s_ram[y / 8u][x] >> (y % 8u)) & 1u;
+}
+
+void sim_ssd1306_dump(FILE *out)
+{
+    uint32_t h = PANEL_VISIBLE_PAGES * 8u;
+
+    fputc('+', out);
+    for (uint32_t x = 0; x < PANEL_W; x++)
+        fputc('-', out);
+    fputs("+\n", out);
+
+    /* two pixel rows per text line keeps the aspect ratio readable */
+    for (uint32_t y = 0; y < h; y += 2u)
+    {
+        fputc('|', out);
+        for (uint32_t x = 0; x < PANEL_W; x++)
+        {
+            bool top = pixel(x, y);
+            bool bot = pixel(x, y + 1u);
+            fputc(top && bot ? '#' : top ? '"' : bot ? '.' : ' ', out);
+        }
+        fputs("|\n", out);
+    }
+
+    fputc('+', out);
+    for (uint32_t x = 0; x < PANEL_W; x++)
+        fputc('-', out);
+    fputs("+\n", out);
+}
+
+bool sim_ssd1306_save_pbm(const char *path)
+{
+    FILE *f = fopen(path, "w");
+    if (!f)
+        return false;
+
+    uint32_t h = PANEL_VISIBLE_PAGES * 8u;
+    fprintf(f, "P1\n%u %u\n", (unsigned) PANEL_W, (unsigned) h);
+    for (uint32_t y = 0; y < h; y++)
+    {
+        for (uint32_t x = 0; x < PANEL_W; x++)
+            fputs(pixel(x, y) ? "1 " : "0 ", f);
+        fputc('\n', f);
+    }
+
+    return fclose(f) == 0;
+}
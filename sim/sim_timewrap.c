@@ -0,0 +1,127 @@
+/* sprout_timewrap: the timebase extension state across both of its wraps
+ * comments are lowercase
+ *
+ * drives timebase_state_init/advance/us64 (timebase.h) with a fake 32-bit
+ * cycle counter for a few hours of virtual time, well past several cyccnt
+ * wraps (~59 s at 72 mhz) and the 32-bit microsecond wrap (~71 min). steps
+ * are random, from one cycle to almost a full counter wrap between two
+ * advances, with reads before and after each advance; some runs start just
+ * before the counter wraps.
+ *
+ * fails (exit 1) when a read goes backwards or differs from the exact
+ * microseconds of the cycles counted so far (the remainder must not be lost).
+ *
+ * usage: sprout_timewrap [-w us_wraps] [-s seed]
+ */
+
+#include "drivers/timebase/timebase.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static uint32_t s_seed = 1u;
+static uint32_t s_checks = 0;
+static uint32_t s_fails = 0;
+
+static uint64_t xorshift64(uint64_t *x)
+{
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+/* one read at total cycles since init; prev is the last read */
+static void check_read(const timebase_state_t *s, uint64_t cycles, uint32_t cyc_per_us,
+                       uint32_t raw0, uint64_t *prev)
+{
+    uint64_t us = timebase_state_us64(s, raw0 + (uint32_t) cycles);
+    uint64_t want = cycles / cyc_per_us;
+
+    s_checks++;
+    if (us != want || us < *prev)
+    {
+        if (s_fails++ < 10u)
+            printf("  %u cyc/us, cycle %llu: read %llu us, want %llu (last %llu)\n",
+                   (unsigned) cyc_per_us,
+                   (unsigned long long) cycles,
+                   (unsigned long long) us,
+                   (unsigned long long) want,
+                   (unsigned long long) *prev);
+    }
+    *prev = us;
+}
+
+/* run until the microsecond count wrapped `wraps` times; returns cyccnt wraps */
+static uint32_t run(uint32_t cyc_per_us, uint32_t raw0, uint32_t wraps, uint64_t *rnd)
+{
+    timebase_state_t s;
+    timebase_state_init(&s, raw0, cyc_per_us);
+
+    uint64_t end = ((uint64_t) wraps << 32) * cyc_per_us + cyc_per_us * 1000u;
+    uint64_t cycles = 0;
+    uint64_t prev = 0;
+
+    while (cycles < end)
+    {
+        /* counter progress between two advances: short mostly, sometimes up to a
+         * whole wrap less the sub-microsecond remainder the base carries
+         */
+        uint64_t r = xorshift64(rnd);
+        uint64_t span = (r & 15u) == 0u ? 0xFFFFFFFFu - cyc_per_us : (r & 4u) ? 0xFFFFFu : 0xFFu;
+        uint64_t step = (r >> 8) % span + 1u;
+
+        /* reads in between see a base that is up to one wrap old */
+        uint64_t mid = cycles + (xorshift64(rnd) % step);
+        check_read(&s, mid, cyc_per_us, raw0, &prev);
+
+        cycles += step;
+        check_read(&s, cycles, cyc_per_us, raw0, &prev);
+        timebase_state_advance(&s, raw0 + (uint32_t) cycles);
+        check_read(&s, cycles, cyc_per_us, raw0, &prev);
+    }
+    return (uint32_t) (((uint64_t) raw0 + cycles) >> 32);
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t wraps = 2u;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "w:s:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'w':
+                wraps = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                s_seed = (uint32_t) strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-w us_wraps] [-s seed]\n", argv[0]);
+                return (opt == 'h') ? 0 : 2;
+        }
+    }
+
+    /* 72 mhz hclk, the 8 mhz hsi, 1 cycle per us and an odd ratio */
+    static const uint32_t rates[] = {72u, 8u, 1u, 7u};
+    uint64_t rnd = 0x9E3779B97F4A7C15ull ^ s_seed;
+
+    for (uint32_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+    {
+        uint32_t raw0 = (i & 1u) ? 0xFFFFFFFFu - rates[i] * 3u : (uint32_t) xorshift64(&rnd);
+        uint32_t before = s_fails;
+        uint32_t cyc_wraps = run(rates[i], raw0, wraps, &rnd);
+        printf("%u cyc/us: %u us wraps, %u cyccnt wraps: %s\n",
+               (unsigned) rates[i],
+               (unsigned) wraps,
+               (unsigned) cyc_wraps,
+               (s_fails == before) ? "ok" : "FAIL");
+    }
+
+    printf("check: %u reads monotonic and exact across both wraps: %s\n",
+           (unsigned) s_checks,
+           s_fails ? "FAIL" : "ok");
+    return s_fails ? 1 : 0;
+}
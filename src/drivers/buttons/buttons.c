@@ -0,0 +1,161 @@
+#include "buttons.h"
+
+/* buttons sit on consecutive pins of one port, in btn_id_t order */
+#define BUTTONS_PORT GPIOB
+#define BUTTONS_FIRST_PIN 12u
+#define BUTTONS_MASK ((1u << btn_count) - 1u)
+
+/* debounced state (bit n = button n pressed) and the 2-bit vertical counter:
+ * bit n of ct1:ct0 counts samples that disagree with the state; an agreeing
+ * sample resets it, the fourth disagreeing one toggles the state
+ */
+static volatile uint32_t s_state = 0;
+static uint32_t s_ct0 = ~0u;
+static uint32_t s_ct1 = ~0u;
+
+static uint32_t s_div = 0;
+static volatile bool s_ready = false;
+
+/* long/repeat timing per button, only touched while it is held */
+static uint32_t s_held_ms[btn_count];
+static uint32_t s_next_ms[btn_count];
+static uint32_t s_long = 0; /* bit n = long press already reported */
+
+/* tick (producer) → main loop (consumer), same scheme as ir_ring.h */
+static btn_event_t s_q[BUTTONS_QUEUE_SIZE];
+static uint32_t s_q_head = 0;
+static uint32_t s_q_tail = 0;
+static uint32_t s_q_overflows = 0;
+
+static bool push(uint32_t button, btn_ev_type_t type, uint32_t held_ms)
+{
+    uint32_t h = s_q_head;
+    uint32_t t = __atomic_load_n(&s_q_tail, __ATOMIC_ACQUIRE);
+    if ((h - t) >= BUTTONS_QUEUE_SIZE)
+    {
+        s_q_overflows++;
+        return false;
+    }
+
+    btn_event_t *e = &s_q[h & (BUTTONS_QUEUE_SIZE - 1u)];
+    e->button = (uint8_t) button;
+    e->type = (uint8_t) type;
+    e->held_ms = (held_ms > 0xFFFFu) ? 0xFFFFu : (uint16_t) held_ms;
+
+    __atomic_store_n(&s_q_head, h + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+void buttons_init(void)
+{
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    GPIO_InitTypeDef gi = {0};
+    gi.Pin = (uint32_t) BUTTONS_MASK << BUTTONS_FIRST_PIN;
+    gi.Mode = GPIO_MODE_INPUT;
+    gi.Pull = GPIO_PULLUP; /* button to gnd */
+    HAL_GPIO_Init(BUTTONS_PORT, &gi);
+
+    s_state = 0;
+    s_ct0 = ~0u;
+    s_ct1 = ~0u;
+    s_long = 0;
+    s_div = 0;
+    __atomic_store_n(&s_ready, true, __ATOMIC_RELEASE);
+}
+
+void buttons_tick(void)
+{
+    if (!s_ready || ++s_div < BUTTONS_SAMPLE_MS)
+        return;
+    s_div = 0;
+
+    /* every button in one read; active low */
+    uint32_t raw = (~BUTTONS_PORT->IDR >> BUTTONS_FIRST_PIN) & BUTTONS_MASK;
+
+    uint32_t state = s_state;
+    uint32_t diff = state ^ raw;
+    s_ct0 = ~(s_ct0 & diff);
+    s_ct1 = s_ct0 ^ (s_ct1 & diff);
+    uint32_t toggle = diff & s_ct0 & s_ct1;
+    state ^= toggle;
+    s_state = state;
+
+    /* nothing changed and nothing held: done in a handful of instructions */
+    uint32_t work = toggle | state;
+    bool queued = false;
+
+    while (work != 0u)
+    {
+        uint32_t b = (uint32_t) __builtin_ctz(work);
+        uint32_t bit = 1u << b;
+        work &= work - 1u;
+
+        if (toggle & bit)
+        {
+            if (state & bit)
+            {
+                s_held_ms[b] = 0;
+                s_next_ms[b] = BUTTONS_LONG_MS;
+                s_long &= ~bit;
+                queued |= push(b, BTN_EV_PRESS, 0);
+            }
+            else
+            {
+                queued |= push(b, BTN_EV_RELEASE, s_held_ms[b]);
+            }
+            continue;
+        }
+
+        /* held */
+        s_held_ms[b] += BUTTONS_SAMPLE_MS;
+        if (s_held_ms[b] < s_next_ms[b])
+            continue;
+
+        if (!(s_long & bit))
+        {
+            s_long |= bit;
+            queued |= push(b, BTN_EV_LONG, s_held_ms[b]);
+        }
+        else
+        {
+            queued |= push(b, BTN_EV_REPEAT, s_held_ms[b]);
+        }
+
+        /* non-repeating buttons stop here until the next press */
+        s_next_ms[b] = (BUTTONS_REPEAT_MASK & bit) ? s_next_ms[b] + BUTTONS_REPEAT_MS : ~0u;
+    }
+
+    if (queued)
+    {
+        buttons_on_pending();
+    }
+}
+
+bool buttons_get(btn_event_t *out)
+{
+    uint32_t t = s_q_tail;
+    uint32_t h = __atomic_load_n(&s_q_head, __ATOMIC_ACQUIRE);
+    if (h == t || !out)
+        return false;
+
+    *out = s_q[t & (BUTTONS_QUEUE_SIZE - 1u)];
+    __atomic_store_n(&s_q_tail, t + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint32_t buttons_state(void)
+{
+    return s_state;
+}
+
+uint32_t buttons_get_overflows(void)
+{
+    return __atomic_load_n(&s_q_overflows, __ATOMIC_RELAXED);
+}
+
+/* default weak hook; user can override elsewhere */
+void __attribute__((weak)) buttons_on_pending(void)
+{
+    /* no-op: the main loop polls buttons_get() */
+}
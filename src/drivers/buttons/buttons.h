@@ -0,0 +1,87 @@
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f1xx_hal.h"
+
+/* inc/dec/ok buttons on pb12..pb14 (active low, internal pull-ups)
+ * - buttons_tick() runs from the 1 khz systick: one gpiob->idr read per sample
+ *   covers every button, no exti, so bouncing contacts cost nothing extra
+ * - debounce is a 2-bit vertical counter over all buttons at once: a button
+ *   changes state after 4 equal samples in a row (BUTTONS_SAMPLE_MS apart)
+ * - press/release/long/repeat events go to a small isr → main loop queue,
+ *   read with buttons_get()
+ */
+
+/* one sample every n ticks (ms); debounce time = 4 x BUTTONS_SAMPLE_MS */
+#ifndef BUTTONS_SAMPLE_MS
+#define BUTTONS_SAMPLE_MS 5u
+#endif
+
+/* held this long → BTN_EV_LONG (once per press) */
+#ifndef BUTTONS_LONG_MS
+#define BUTTONS_LONG_MS 800u
+#endif
+
+/* after BTN_EV_LONG, buttons in BUTTONS_REPEAT_MASK send BTN_EV_REPEAT at this period */
+#ifndef BUTTONS_REPEAT_MS
+#define BUTTONS_REPEAT_MS 150u
+#endif
+
+#ifndef BUTTONS_REPEAT_MASK
+#define BUTTONS_REPEAT_MASK ((1u << btn_inc) | (1u << btn_dec))
+#endif
+
+/* event queue size; must be a power of two */
+#ifndef BUTTONS_QUEUE_SIZE
+#define BUTTONS_QUEUE_SIZE 16u
+#endif
+
+#if (BUTTONS_QUEUE_SIZE & (BUTTONS_QUEUE_SIZE - 1u)) != 0u
+#error "BUTTONS_QUEUE_SIZE must be a power of two"
+#endif
+
+/* fixed mapping: pb12→inc, pb13→dec, pb14→ok */
+typedef enum
+{
+    btn_inc = 0,
+    btn_dec = 1,
+    btn_ok = 2,
+    btn_count = 3
+} btn_id_t;
+
+typedef enum
+{
+    BTN_EV_PRESS = 0, /* debounced press */
+    BTN_EV_RELEASE,   /* debounced release; held_ms tells a click from a long press */
+    BTN_EV_LONG,      /* still held after BUTTONS_LONG_MS */
+    BTN_EV_REPEAT     /* auto-repeat while held past the long press */
+} btn_ev_type_t;
+
+typedef struct
+{
+    uint8_t button;   /* btn_id_t */
+    uint8_t type;     /* btn_ev_type_t */
+    uint16_t held_ms; /* time since the press (saturates) */
+} btn_event_t;
+
+/* configure pb12..pb14 as inputs with pull-up; call before systick sampling matters */
+void buttons_init(void);
+
+/* 1 ms tick; call from SysTick_Handler */
+void buttons_tick(void);
+
+/* next queued event; false when empty (main loop side) */
+bool buttons_get(btn_event_t *out);
+
+/* debounced state, bit n = button n pressed */
+uint32_t buttons_state(void);
+
+/* events dropped because the queue was full */
+uint32_t buttons_get_overflows(void);
+
+/* optional hook, called from the tick after events were queued (weak default) */
+void buttons_on_pending(void);
+
+#endif /* BUTTONS_H */
@@ -1,18 +1,135 @@
 #include "drivers/display/display.h"
 #include "drivers/system/system.h"
 #include "drivers/i2c/i2c.h"
+#include "drivers/prof/prof.h"
 #include "stm32f1xx_hal.h"
 #include <string.h>
 
+/* 1: the count screen is drawn from precomputed glyph tiles straight onto the
+ * wire (only changed characters are sent); 0: through u8g2 like other screens
+ */
+#ifndef DISPLAY_COUNTS_TILES
+#define DISPLAY_COUNTS_TILES 1
+#endif
+
+#if DISPLAY_COUNTS_TILES
+#include "drivers/display/display_glyphs.h"
+#endif
+
 /* address note: many 128x32 ssd1306 boards use 0x3c; some use 0x3d */
 #ifndef SSD1306_ADDR_7BIT
 #define SSD1306_ADDR_7BIT 0x3C
 #endif
 
+/* staging area for one frame of i2c transactions, pushed out by dma.
+ * u8g2 hands us start/send/end per transaction; we copy them here and
+ * chain the dma writes from the completion callback.
+ */
+#ifndef DISPLAY_TX_BYTES
+#define DISPLAY_TX_BYTES 768u
+#endif
+#ifndef DISPLAY_TX_SEGS
+#define DISPLAY_TX_SEGS 48u
+#endif
+
+/* largest single transaction u8g2 emits (ssd13xx cad: control byte + data chunk) */
+#define DISPLAY_TX_MAX_SEG 64u
+
+/* transport profile defaults (display_set_tx_profile()):
+ * - DISPLAY_TX_MAX_XFER: consecutive transactions of the same kind (commands
+ *   or data) are joined into one of at most this many bytes, saving a start,
+ *   address byte and stop each; 0 = no limit, 1 = never join (u8g2's chunks)
+ * - DISPLAY_TX_STREAM: rows where every tile changed go out in horizontal
+ *   addressing mode, one continuous stream, so a full frame is one transaction
+ */
+#ifndef DISPLAY_TX_MAX_XFER
+#define DISPLAY_TX_MAX_XFER 0u
+#endif
+#ifndef DISPLAY_TX_STREAM
+#define DISPLAY_TX_STREAM 1
+#endif
+
+/* how long a caller may wait for the previous frame to drain */
+#ifndef DISPLAY_TX_TIMEOUT_MS
+#define DISPLAY_TX_TIMEOUT_MS 50u
+#endif
+
+/* panel geometry in 8x8 tiles (one tile = 8 column bytes of one page) */
+#define DISPLAY_TILES_X 16u
+#define DISPLAY_TILES_Y 4u
+#define DISPLAY_TILE_BYTES 8u
+#define DISPLAY_TILES (DISPLAY_TILES_X * DISPLAY_TILES_Y)
+
+/* u8g2 buffer: whole frame, or DISPLAY_PAGES tile rows drawn one after another */
+#if DISPLAY_PAGES == 0
+#define DISPLAY_SETUP u8g2_Setup_ssd1306_i2c_128x32_univision_f
+#define DISPLAY_BUF_ROWS DISPLAY_TILES_Y
+#elif DISPLAY_PAGES == 1
+#define DISPLAY_SETUP u8g2_Setup_ssd1306_i2c_128x32_univision_1
+#define DISPLAY_BUF_ROWS 1u
+#elif DISPLAY_PAGES == 2
+#define DISPLAY_SETUP u8g2_Setup_ssd1306_i2c_128x32_univision_2
+#define DISPLAY_BUF_ROWS 2u
+#else
+#error "DISPLAY_PAGES must be 0 (full buffer), 1 or 2"
+#endif
+
+/* page mode: frames between two full refreshes (see tile_changed()) */
+#ifndef DISPLAY_REFRESH_FRAMES
+#define DISPLAY_REFRESH_FRAMES 64u
+#endif
+
 /* local state */
 static u8g2_t s_u8g2;
 static bool s_ready = false;
 
+/* what the panel shows, to send only tiles that differ. the full buffer keeps
+ * a copy; page mode has no frame to compare against once a page is drawn, so
+ * it keeps a 16-bit signature per tile (1/4 of the copy) instead
+ */
+#if DISPLAY_PAGES == 0
+static uint8_t s_shadow[DISPLAY_TILES * DISPLAY_TILE_BYTES];
+#else
+static uint16_t s_sig[DISPLAY_TILES];
+static uint8_t s_refresh = 0;
+#endif
+static bool s_force = false; /* next frame sends every tile */
+
+#if DISPLAY_COUNTS_TILES
+/* count screen: two lines of 6-pixel cells on pages 0 and 3. s_cells holds
+ * the characters on the panel while s_counts_shown; any other screen drawn
+ * through u8g2 ends it and resends its whole frame
+ */
+#define CELL_W (DISPLAY_GLYPH_W + 1u)
+#define CELLS_X (128u / CELL_W)
+#define COUNTS_LINES 2u
+
+static const uint8_t s_counts_page[COUNTS_LINES] = {0, 3};
+static char s_cells[COUNTS_LINES][CELLS_X];
+static bool s_counts_shown = false;
+#endif
+static display_stats_t s_stats;
+
+static uint8_t s_tx[DISPLAY_TX_BYTES];
+static uint16_t s_seg_end[DISPLAY_TX_SEGS]; /* end offset of each staged transaction */
+static uint16_t s_fill;                     /* bytes staged */
+static uint8_t s_nseg;                      /* transactions staged */
+static volatile uint8_t s_next;             /* next transaction to send */
+static volatile bool s_tx_busy = false;
+static volatile bool s_tx_lost = false; /* a frame failed part way: resend everything */
+static uint8_t s_addr7 = SSD1306_ADDR_7BIT;
+
+static display_tx_profile_t s_prof = {DISPLAY_TX_MAX_XFER, DISPLAY_TX_STREAM};
+
+/* ssd1306 addressing mode as last set by us (0x20 command argument) */
+#define AMODE_HORIZONTAL 0x00u
+#define AMODE_PAGE 0x02u
+#define AMODE_UNKNOWN 0xFFu
+#define STREAM_NONE 0xFFu
+
+static uint8_t s_amode = AMODE_UNKNOWN;
+static uint8_t s_stream_next = STREAM_NONE; /* tile row the horizontal stream is at */
+
 /* ---- u8g2 callbacks (embedded here) -------------------------------------- */
 
 static i2c_bus_t *bus(void)
@@ -20,11 +137,210 @@ static i2c_bus_t *bus(void)
     return system_i2c1();
 }
 
-/* i2c byte callback (u8g2 → our generic i2c, polling) */
+/* dma completion (isr): start the next staged transaction or go idle */
+static void tx_done(i2c_bus_t *b, i2c_status_t st, void *ctx)
+{
+    (void) ctx;
+
+    uint8_t i = s_next;
+    if (st != I2C_ST_OK)
+    {
+        /* bus error: drop the rest of the frame, the panel is out of step */
+        s_tx_lost = true;
+        s_tx_busy = false;
+        return;
+    }
+    if (i >= s_nseg)
+    {
+        s_tx_busy = false;
+        return;
+    }
+
+    uint16_t from = i ? s_seg_end[i - 1] : 0;
+    s_next = (uint8_t) (i + 1);
+    if (i2c_write_dma(b, s_addr7, &s_tx[from], s_seg_end[i] - from, tx_done, NULL) != I2C_ST_OK)
+    {
+        s_tx_lost = true;
+        s_tx_busy = false;
+    }
+}
+
+/* wait until the previous frame left the staging area; false on timeout.
+ * the bus watchdog runs meanwhile, so a hung transfer ends at its deadline
+ * (the recovery fails it and tx_done() goes idle)
+ */
+static bool tx_wait(void)
+{
+    uint32_t t0 = HAL_GetTick();
+    while (s_tx_busy)
+    {
+        i2c_service(bus());
+        if ((HAL_GetTick() - t0) > DISPLAY_TX_TIMEOUT_MS)
+        {
+            /* still going: stop the engine before the staging area is reused,
+             * the dma may still be reading it
+             */
+            (void) i2c_recover(bus());
+            s_tx_lost = true;
+            s_tx_busy = false;
+            return false;
+        }
+    }
+    return true;
+}
+
+/* circuit breaker: no frame is drawn or staged while the bus is down */
+static bool link_up(void)
+{
+    return i2c_ok(bus());
+}
+
+/* push everything staged so far; returns immediately */
+static void tx_kick(void)
+{
+    if (s_tx_busy || s_nseg == 0)
+        return;
+
+    s_next = 0;
+    s_tx_busy = true;
+    tx_done(bus(), I2C_ST_OK, NULL);
+}
+
+/* staging must be empty before u8g2 writes into it again */
+static void tx_reset(void)
+{
+    (void) tx_wait();
+    s_fill = 0;
+    s_nseg = 0;
+    s_next = 0;
+}
+
+/* one i2c transaction into the staging area: begin, put..., end */
+static uint16_t s_seg_start;
+
+static void stage_begin(void)
+{
+    /* out of room: send what we have and start over */
+    if ((s_fill + DISPLAY_TX_MAX_SEG) > DISPLAY_TX_BYTES || s_nseg >= DISPLAY_TX_SEGS)
+    {
+        tx_kick();
+        tx_reset();
+    }
+    s_seg_start = s_fill;
+}
+
+static bool stage_put(const uint8_t *data, uint32_t n)
+{
+    while (n--)
+    {
+        if (s_fill >= DISPLAY_TX_BYTES)
+            return false;
+        s_tx[s_fill++] = *data++;
+    }
+    return true;
+}
+
+/* the staged transaction continues the one before: same control byte with
+ * co = 0 (all commands or all data) and the joined length within the profile
+ */
+static bool stage_joins(uint32_t len)
+{
+    if (s_nseg == 0u || s_prof.max_xfer == 1u)
+        return false;
+
+    uint16_t prev = (s_nseg > 1u) ? s_seg_end[s_nseg - 2u] : 0u;
+    uint8_t ctrl = s_tx[s_seg_start];
+    if ((ctrl != 0x00u && ctrl != 0x40u) || s_tx[prev] != ctrl)
+        return false;
+    return s_prof.max_xfer == 0u || (s_seg_start - prev) + len - 1u <= s_prof.max_xfer;
+}
+
+static void stage_end(void)
+{
+    uint32_t len = (uint32_t) (s_fill - s_seg_start);
+    if (len == 0u)
+        return;
+
+    if (stage_joins(len))
+    {
+        /* drop the control byte: no start, address or stop of its own */
+        memmove(&s_tx[s_seg_start], &s_tx[s_seg_start + 1u], len - 1u);
+        s_fill--;
+        s_seg_end[s_nseg - 1u] = s_fill;
+        s_stats.bytes_last += len - 1u;
+        return;
+    }
+
+    s_seg_end[s_nseg++] = s_fill;
+    /* payload + address byte */
+    s_stats.bytes_last += len + 1u;
+}
+
+/* a command-only transaction */
+static void stage_cmds(const uint8_t *cmd, uint32_t n)
+{
+    static const uint8_t ctrl = 0x00;
+
+    stage_begin();
+    (void) stage_put(&ctrl, 1);
+    (void) stage_put(cmd, n);
+    stage_end();
+}
+
+/* gddram bytes in transactions of at most DISPLAY_TX_MAX_SEG; the profile
+ * joins them into longer ones
+ */
+static void stage_data(const uint8_t *data, uint32_t n)
+{
+    static const uint8_t ctrl = 0x40;
+
+    while (n != 0u)
+    {
+        uint32_t k = (n < DISPLAY_TX_MAX_SEG - 1u) ? n : DISPLAY_TX_MAX_SEG - 1u;
+        stage_begin();
+        (void) stage_put(&ctrl, 1);
+        (void) stage_put(data, k);
+        stage_end();
+        data += k;
+        n -= k;
+    }
+}
+
+/* switch the addressing mode if needed. anything but the stream moves the
+ * gddram pointer, so leaving horizontal mode ends the stream
+ */
+static void set_amode(uint8_t mode)
+{
+    if (mode != AMODE_HORIZONTAL)
+        s_stream_next = STREAM_NONE;
+    if (s_amode == mode)
+        return;
+
+    const uint8_t cmd[] = {0x20, mode};
+    stage_cmds(cmd, sizeof(cmd));
+    s_amode = mode;
+}
+
+/* whole tile row ty as part of a horizontal stream over the full width: a
+ * window from ty to the last page is set only where the stream does not
+ * already continue, so consecutive rows need no commands at all
+ */
+static void stream_row(const uint8_t *line, uint8_t ty)
+{
+    if (s_amode != AMODE_HORIZONTAL || s_stream_next != ty)
+    {
+        set_amode(AMODE_HORIZONTAL);
+        const uint8_t cmd[] = {0x21, 0, 127, 0x22, ty, (uint8_t) (DISPLAY_TILES_Y - 1u)};
+        stage_cmds(cmd, sizeof(cmd));
+    }
+    stage_data(line, DISPLAY_TILES_X * DISPLAY_TILE_BYTES);
+    s_stream_next = (uint8_t) (ty + 1u);
+}
+
+/* i2c byte callback (u8g2 → staging buffer, sent later via dma) */
 static uint8_t u8x8_byte_stm32_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, void *arg_ptr)
 {
-    static uint8_t txbuf[32];
-    static uint8_t idx;
+    PROF_SCOPE(u8x8_byte);
 
     switch (msg)
     {
@@ -33,31 +349,15 @@ static uint8_t u8x8_byte_stm32_i2c(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, v
             return 1;
 
         case U8X8_MSG_BYTE_START_TRANSFER:
-            idx = 0;
+            stage_begin();
+            s_addr7 = (uint8_t) (u8x8_GetI2CAddress(u8x8) >> 1);
             return 1;
 
         case U8X8_MSG_BYTE_SEND:
-        {
-            uint8_t *data = (uint8_t *) arg_ptr;
-            while (arg_int--)
-            {
-                if (idx >= sizeof(txbuf))
-                {
-                    (void) i2c_write(
-                            bus(), (uint8_t) (u8x8_GetI2CAddress(u8x8) >> 1), txbuf, idx, 10);
-                    idx = 0;
-                }
-                txbuf[idx++] = *data++;
-            }
-            return 1;
-        }
+            return stage_put((const uint8_t *) arg_ptr, arg_int) ? 1 : 0;
 
         case U8X8_MSG_BYTE_END_TRANSFER:
-            if (idx)
-            {
-                (void) i2c_write(bus(), (uint8_t) (u8x8_GetI2CAddress(u8x8) >> 1), txbuf, idx, 20);
-                idx = 0;
-            }
+            stage_end();
             return 1;
 
         default:
@@ -74,6 +374,9 @@ static uint8_t u8x8_gpio_and_delay_stm32(u8x8_t *u8x8, uint8_t msg, uint8_t arg_
     switch (msg)
     {
         case U8X8_MSG_DELAY_MILLI:
+            /* delays order the staged commands: flush them first */
+            tx_kick();
+            tx_reset();
             HAL_Delay((uint32_t) arg_int);
             return 1;
 
@@ -110,42 +413,431 @@ bool display_init(void)
         return false;
     }
 
-    /* configure u8g2 for ssd1306 128x32 i2c, full buffer */
-    u8g2_Setup_ssd1306_i2c_128x32_univision_f(
-            &s_u8g2, U8G2_R0, u8x8_byte_stm32_i2c, u8x8_gpio_and_delay_stm32);
+    /* configure u8g2 for ssd1306 128x32 i2c, full or page buffer */
+    DISPLAY_SETUP(&s_u8g2, U8G2_R0, u8x8_byte_stm32_i2c, u8x8_gpio_and_delay_stm32);
 
     /* u8g2 expects 8-bit address; shift our 7-bit */
     u8x8_SetI2CAddress(&s_u8g2.u8x8, (uint8_t) (SSD1306_ADDR_7BIT << 1));
 
+    tx_reset();
+    s_amode = AMODE_UNKNOWN; /* whatever the u8g2 init sequence leaves */
+    s_stream_next = STREAM_NONE;
     u8g2_InitDisplay(&s_u8g2);
     u8g2_SetPowerSave(&s_u8g2, 0);
 
-    u8g2_SetFont(&s_u8g2, u8g2_font_6x10_tf);
-    u8g2_ClearBuffer(&s_u8g2);
-    u8g2_DrawStr(&s_u8g2, 0, 10, "SPROUT COUNTER");
-    u8g2_DrawStr(&s_u8g2, 0, 28, "FIRMWARE VERSION V1.0");
-    u8g2_SendBuffer(&s_u8g2);
+    tx_kick();
 
+    /* the panel content is unknown: the first frame sends every tile */
+    s_force = true;
     s_ready = true;
+    display_write_version();
+    return true;
+}
+
+/* true if the tile at index i differs from the panel; records it as sent */
+static bool tile_changed(const uint8_t *tile, uint32_t i)
+{
+#if DISPLAY_PAGES == 0
+    uint8_t *old = &s_shadow[i * DISPLAY_TILE_BYTES];
+    if (!s_force && memcmp(tile, old, DISPLAY_TILE_BYTES) == 0)
+        return false;
+    memcpy(old, tile, DISPLAY_TILE_BYTES);
     return true;
+#else
+    /* a signature can collide and leave a stale tile behind; the periodic
+     * full refresh bounds how long it stays
+     */
+    uint32_t a;
+    uint32_t b;
+    memcpy(&a, tile, 4);
+    memcpy(&b, tile + 4, 4);
+    uint32_t h = ((a * 0x9E3779B1u) ^ b) * 0x85EBCA77u;
+    uint16_t sig = (uint16_t) (h >> 16);
+
+    if (!s_force && s_sig[i] == sig)
+        return false;
+    s_sig[i] = sig;
+    return true;
+#endif
+}
+
+/* stage the changed tiles of the tile rows in the buffer (row0 ..). a row
+ * where every tile changed joins the horizontal stream (s_prof.stream); else
+ * runs of dirty tiles on a page go out as one area, and a single clean tile
+ * between two runs is sent too, as that is cheaper than a new address setup
+ */
+static void stage_rows(const uint8_t *buf, uint8_t row0)
+{
+    for (uint8_t r = 0; r < DISPLAY_BUF_ROWS; r++)
+    {
+        uint8_t ty = (uint8_t) (row0 + r);
+        const uint8_t *line = &buf[(size_t) r * DISPLAY_TILES_X * DISPLAY_TILE_BYTES];
+        uint32_t base = (uint32_t) ty * DISPLAY_TILES_X;
+
+        /* bit n = tile n differs from the panel */
+        uint32_t dirty = 0;
+        for (uint8_t tx = 0; tx < DISPLAY_TILES_X; tx++)
+        {
+            if (tile_changed(&line[tx * DISPLAY_TILE_BYTES], base + tx))
+                dirty |= 1u << tx;
+        }
+
+        if (dirty == 0u)
+            continue;
+        if (s_prof.stream && dirty == (1u << DISPLAY_TILES_X) - 1u)
+        {
+            stream_row(line, ty);
+            continue;
+        }
+
+        set_amode(AMODE_PAGE);
+        while (dirty != 0u)
+        {
+            uint8_t first = (uint8_t) __builtin_ctz(dirty);
+            uint8_t last = first;
+            dirty &= dirty - 1u;
+
+            /* extend over gaps of one clean tile */
+            while (dirty != 0u && (uint8_t) __builtin_ctz(dirty) <= (uint8_t) (last + 2u))
+            {
+                last = (uint8_t) __builtin_ctz(dirty);
+                dirty &= dirty - 1u;
+            }
+
+            u8x8_DrawTile(u8g2_GetU8x8(&s_u8g2), first, ty, (uint8_t) (last - first + 1u),
+                          (uint8_t *) &line[first * DISPLAY_TILE_BYTES]);
+        }
+    }
+}
+
+void display_render(display_render_fn_t fn, void *ctx)
+{
+    if (!s_ready || !fn || !link_up())
+        return;
+
+    PROF_SCOPE(display_frame);
+
+    /* the previous frame is waited for only here, so drawing overlaps with
+     * the transfer in flight
+     */
+    tx_reset();
+    s_stats.bytes_last = 0;
+    s_stream_next = STREAM_NONE;
+
+    if (s_tx_lost)
+    {
+        s_tx_lost = false;
+        s_force = true;
+    }
+
+#if DISPLAY_COUNTS_TILES
+    if (s_counts_shown)
+    {
+        /* the panel no longer matches the shadow / signatures */
+        s_counts_shown = false;
+        s_force = true;
+    }
+#endif
+
+#if DISPLAY_PAGES != 0
+    if (++s_refresh >= DISPLAY_REFRESH_FRAMES)
+    {
+        s_refresh = 0;
+        s_force = true;
+    }
+#endif
+
+    /* first/next page loop: with the full buffer this runs once */
+    uint8_t *buf = u8g2_GetBufferPtr(&s_u8g2);
+    for (uint8_t row = 0; row < DISPLAY_TILES_Y; row = (uint8_t) (row + DISPLAY_BUF_ROWS))
+    {
+        u8g2_SetBufferCurrTileRow(&s_u8g2, row);
+        u8g2_ClearBuffer(&s_u8g2);
+        fn(&s_u8g2, ctx);
+        stage_rows(buf, row);
+    }
+    s_force = false;
+
+    tx_kick();
+
+    s_stats.frames++;
+    s_stats.bytes_total += s_stats.bytes_last;
+}
+
+/* a few strings in the 6x10 font */
+typedef struct
+{
+    const char *s;
+    uint8_t x;
+    uint8_t y; /* baseline */
+} text_t;
+
+typedef struct
+{
+    const text_t *t;
+    uint8_t n;
+} texts_t;
+
+static void draw_texts(u8g2_t *u8g2, void *ctx)
+{
+    const texts_t *tt = (const texts_t *) ctx;
+
+    u8g2_SetFont(u8g2, u8g2_font_6x10_tf);
+    for (uint8_t i = 0; i < tt->n; i++)
+    {
+        if (tt->t[i].s)
+            u8g2_DrawStr(u8g2, tt->t[i].x, tt->t[i].y, tt->t[i].s);
+    }
 }
 
 void display_write_text(uint8_t x, uint8_t y, const char *msg)
 {
-    if (!s_ready || !msg)
+    if (!msg)
         return;
-    u8g2_ClearBuffer(&s_u8g2);
-    u8g2_SetFont(&s_u8g2, u8g2_font_6x10_tf);
-    u8g2_DrawStr(&s_u8g2, x, y, msg);
-    u8g2_SendBuffer(&s_u8g2);
+
+    text_t t = {msg, x, y};
+    texts_t tt = {&t, 1};
+    display_render(draw_texts, &tt);
 }
 
 void display_write_version(void)
 {
-    u8g2_ClearBuffer(&s_u8g2);
-    u8g2_DrawStr(&s_u8g2, 0, 10, "SPROUT COUNTER");
-    u8g2_DrawStr(&s_u8g2, 0, 28, "FIRMWARE VERSION V1.0");
-    u8g2_SendBuffer(&s_u8g2);
+    static const text_t t[] = {{"SPROUT COUNTER", 0, 10}, {"FIRMWARE VERSION V1.0", 0, 28}};
+    texts_t tt = {t, 2};
+    display_render(draw_texts, &tt);
+}
+
+void display_write_lines(const char *const *lines, uint8_t n)
+{
+    if (!lines)
+        return;
+
+    /* 6x10 font: three lines fit the 32 px panel */
+    text_t t[3];
+    texts_t tt = {t, 0};
+    for (uint8_t i = 0; i < n && i < 3u; i++)
+    {
+        t[i].s = lines[i];
+        t[i].x = 0;
+        t[i].y = (uint8_t) (9u + 10u * i);
+        tt.n++;
+    }
+    display_render(draw_texts, &tt);
+}
+
+/* decimal without printf; returns the end of the string */
+static char *fmt_u32(char *p, uint32_t v)
+{
+    char tmp[10];
+    uint8_t n = 0;
+    do
+    {
+        tmp[n++] = (char) ('0' + (v % 10u));
+        v /= 10u;
+    } while (v != 0u);
+    while (n)
+    {
+        *p++ = tmp[--n];
+    }
+    *p = '\0';
+    return p;
+}
+
+#if DISPLAY_COUNTS_TILES
+/* ssd1306 column/page address setup, in the order u8x8 uses for tiles */
+static void put_addr(uint8_t page, uint8_t col)
+{
+    const uint8_t cmd[] = {(uint8_t) (0x10u | (col >> 4)), (uint8_t) (col & 0x0Fu),
+                           (uint8_t) (0xB0u | page)};
+    set_amode(AMODE_PAGE);
+    stage_cmds(cmd, sizeof(cmd));
+}
+
+/* n characters from column col of a page: glyph columns plus one blank each */
+static void put_cells(uint8_t page, uint8_t col, const char *c, uint32_t n)
+{
+    /* whole cells per data transaction (control byte + columns) */
+    const uint32_t per_seg = (DISPLAY_TX_MAX_SEG - 1u) / CELL_W;
+
+    put_addr(page, col);
+    while (n != 0u)
+    {
+        uint32_t k = (n < per_seg) ? n : per_seg;
+        static const uint8_t ctrl = 0x40;
+        static const uint8_t gap = 0x00;
+
+        stage_begin();
+        (void) stage_put(&ctrl, 1);
+        for (uint32_t i = 0; i < k; i++)
+        {
+            uint8_t ch = (uint8_t) c[i];
+            if (ch >= DISPLAY_GLYPH_FIRST && ch <= DISPLAY_GLYPH_LAST)
+                (void) stage_put(display_glyphs[ch - DISPLAY_GLYPH_FIRST], DISPLAY_GLYPH_W);
+            else
+                (void) stage_put(display_glyphs[0], DISPLAY_GLYPH_W); /* ' ' is blank */
+            (void) stage_put(&gap, 1);
+        }
+        stage_end();
+
+        c += k;
+        n -= k;
+    }
+}
+
+/* blank the whole panel (entering the count screen from a u8g2 screen) */
+static void clear_panel(void)
+{
+    static const uint8_t zero[DISPLAY_TILES_X * DISPLAY_TILE_BYTES] = {0};
+
+    for (uint8_t page = 0; page < DISPLAY_TILES_Y; page++)
+    {
+        if (s_prof.stream)
+        {
+            stream_row(zero, page);
+        }
+        else
+        {
+            put_addr(page, 0);
+            stage_data(zero, sizeof(zero));
+        }
+    }
+}
+
+/* send the characters of each line that differ from the panel */
+static void counts_frame(const char *const *text)
+{
+    PROF_SCOPE(display_counts);
+
+    tx_reset();
+    s_stats.bytes_last = 0;
+    s_stream_next = STREAM_NONE;
+
+    if (s_tx_lost)
+    {
+        /* start over from a blank panel */
+        s_tx_lost = false;
+        s_counts_shown = false;
+    }
+
+    if (!s_counts_shown)
+    {
+        clear_panel();
+        memset(s_cells, ' ', sizeof(s_cells));
+        s_counts_shown = true;
+    }
+
+    for (uint32_t l = 0; l < COUNTS_LINES; l++)
+    {
+        /* the line padded with blanks to the full width */
+        char want[CELLS_X];
+        const char *t = text[l];
+        for (uint32_t i = 0; i < CELLS_X; i++)
+        {
+            want[i] = (*t != '\0') ? *t++ : ' ';
+        }
+
+        char *have = s_cells[l];
+        uint32_t i = 0;
+        while (i < CELLS_X)
+        {
+            if (want[i] == have[i])
+            {
+                i++;
+                continue;
+            }
+
+            uint32_t first = i;
+            while (i < CELLS_X && want[i] != have[i])
+            {
+                i++;
+            }
+            put_cells(s_counts_page[l], (uint8_t) (first * CELL_W), &want[first], i - first);
+            memcpy(&have[first], &want[first], i - first);
+        }
+    }
+
+    tx_kick();
+
+    s_stats.frames++;
+    s_stats.bytes_total += s_stats.bytes_last;
+}
+#endif
+
+/* "TOTAL 1234" or "TOTAL 1234/5000"; buf holds at least 28 chars */
+static void fmt_total(char *buf, uint32_t total, uint32_t target)
+{
+    memcpy(buf, "TOTAL ", 6);
+    char *end = fmt_u32(buf + 6, total);
+    if (target != 0u)
+    {
+        *end++ = '/';
+        (void) fmt_u32(end, target);
+    }
+}
+
+void display_show_target(uint32_t total, uint32_t target)
+{
+    if (!s_ready)
+        return;
+
+    char line[32];
+    fmt_total(line, total, target);
+
+    text_t t[] = {{"TARGET REACHED", 0, 10}, {line, 0, 28}};
+    texts_t tt = {t, 2};
+    display_render(draw_texts, &tt);
+}
+
+void display_show_counts(const uint32_t *counts, uint8_t n, uint32_t total, uint32_t target)
+{
+    if (!s_ready || !counts || !link_up())
+        return;
+
+    /* "TOTAL 1234" (or "TOTAL 1234/5000" with a target) on top, "A12 B5 C7" below */
+    char top[32];
+    fmt_total(top, total, target);
+
+    char line[32];
+    char *p = line;
+    *p = '\0';
+    for (uint8_t i = 0; i < n && (p - line) < (int) (sizeof(line) - 12u); i++)
+    {
+        if (i)
+            *p++ = ' ';
+        *p++ = (char) ('A' + i);
+        p = fmt_u32(p, counts[i]);
+    }
+
+#if DISPLAY_COUNTS_TILES
+    const char *text[COUNTS_LINES] = {top, line};
+    counts_frame(text);
+#else
+    text_t t[] = {{top, 0, 10}, {line, 0, 28}};
+    texts_t tt = {t, 2};
+    display_render(draw_texts, &tt);
+#endif
+}
+
+void display_set_tx_profile(const display_tx_profile_t *p)
+{
+    if (p)
+        s_prof = *p;
+}
+
+display_tx_profile_t display_get_tx_profile(void)
+{
+    return s_prof;
+}
+
+bool display_busy(void)
+{
+    /* with the bus down, frames wait (the governor keeps them pending) */
+    return s_tx_busy || !link_up();
+}
+
+display_stats_t display_get_stats(void)
+{
+    return s_stats;
 }
 
 u8g2_t *display_u8g2(void)
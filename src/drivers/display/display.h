@@ -5,18 +5,80 @@
 #include <stdbool.h>
 #include "u8g2.h"
 
+/* u8g2 buffer: 0 = full frame (512 bytes, u8g2 "_f"), 1 or 2 = page buffer of
+ * that many 8-pixel pages (128 / 256 bytes, "_1" / "_2"). in page mode a
+ * screen is drawn once per page, so screens are render callbacks.
+ */
+#ifndef DISPLAY_PAGES
+#define DISPLAY_PAGES 0
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
 #endif
 
+    /* transfer accounting for frames sent after display_init() */
+    typedef struct
+    {
+        uint32_t frames;      /* frames pushed */
+        uint32_t bytes_last;  /* bytes on the wire for the last frame (incl. address bytes) */
+        uint32_t bytes_total; /* sum over all frames */
+    } display_stats_t;
+
+    /* how frames are cut into i2c transactions; defaults DISPLAY_TX_MAX_XFER and
+ * DISPLAY_TX_STREAM (display.c)
+ */
+    typedef struct
+    {
+        uint16_t max_xfer; /* join transactions up to this many bytes; 0 = no limit, 1 = never */
+        bool stream;       /* fully changed rows go out as one horizontal-mode stream */
+    } display_tx_profile_t;
+
     /* initialize u8g2 over i2c (i2c1 on pb6/pb7) for a 128x32 ssd1306 */
     bool display_init(void);
 
-    /* draw a text line at (x,y) using a small readable font */
+    /* draws a whole screen into u8g2 (buffer already cleared). in page mode it
+ * is called once per page with the buffer covering only that page, so it
+ * must draw the same screen every time; ctx must stay valid for the call.
+ */
+    typedef void (*display_render_fn_t)(u8g2_t *u8g2, void *ctx);
+
+    /* draw a screen with fn and send the tiles that changed, by dma in the
+ * background; waits only if the previous frame is still on the wire
+ */
+    void display_render(display_render_fn_t fn, void *ctx);
+
+    /* draw a text line at (x,y) using a small readable font (a display_render() screen) */
     void display_write_text(uint8_t x, uint8_t y, const char *msg);
     void display_write_version(void);
-    /* expose u8g2 handle for advanced drawings (returns null if not ready) */
+
+    /* up to three lines of small text, e.g. a page of prof_dump() output */
+    void display_write_lines(const char *const *lines, uint8_t n);
+
+    /* counter screen: total (and target unless 0) on the first line, one count
+ * per channel below. drawn from precomputed glyph tiles, only changed
+ * characters are sent (DISPLAY_COUNTS_TILES, see display.c)
+ */
+    void display_show_counts(const uint32_t *counts, uint8_t n, uint32_t total, uint32_t target);
+
+    /* "TARGET REACHED" with the total and target below */
+    void display_show_target(uint32_t total, uint32_t target);
+
+    /* true while a frame transfer is still in flight, or while the i2c bus is
+ * down (i2c_service()): frames are skipped then
+ */
+    bool display_busy(void);
+
+    display_stats_t display_get_stats(void);
+
+    /* takes effect from the next frame */
+    void display_set_tx_profile(const display_tx_profile_t *p);
+    display_tx_profile_t display_get_tx_profile(void);
+
+    /* expose u8g2 handle (returns null if not ready); draw from a
+ * display_render() callback, the buffer may only hold one page
+ */
     u8g2_t *display_u8g2(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,63 @@
+#ifndef DISPLAY_GLYPHS_H
+#define DISPLAY_GLYPHS_H
+
+#include <stdint.h>
+
+/* 5x7 glyphs for the tile count screen, in ssd1306 page format: one byte per
+ * column, bit 0 = top row. each glyph is written below as 7 rows of 5 bits
+ * (msb = left column) and transposed to columns by the preprocessor, so the
+ * table in flash is ready to send as is.
+ * only ' ' .. 'Z' are covered; characters without an entry are blank.
+ */
+
+#define DISPLAY_GLYPH_W 5u
+#define DISPLAY_GLYPH_FIRST ' '
+#define DISPLAY_GLYPH_LAST 'Z'
+
+#define GLYPH_BIT(row, col, n) ((((row) >> (4 - (col))) & 1u) << (n))
+#define GLYPH_COL(c, r0, r1, r2, r3, r4, r5, r6)                                                   \
+    (uint8_t) (GLYPH_BIT(r0, c, 0) | GLYPH_BIT(r1, c, 1) | GLYPH_BIT(r2, c, 2) |                   \
+               GLYPH_BIT(r3, c, 3) | GLYPH_BIT(r4, c, 4) | GLYPH_BIT(r5, c, 5) |                   \
+               GLYPH_BIT(r6, c, 6))
+#define GLYPH(...)                                                                                 \
+    {                                                                                              \
+        GLYPH_COL(0, __VA_ARGS__), GLYPH_COL(1, __VA_ARGS__), GLYPH_COL(2, __VA_ARGS__),           \
+            GLYPH_COL(3, __VA_ARGS__), GLYPH_COL(4, __VA_ARGS__)                                   \
+    }
+#define GLYPH_AT(ch) [(ch) - DISPLAY_GLYPH_FIRST]
+
+/* only display.c includes this */
+static const uint8_t display_glyphs[DISPLAY_GLYPH_LAST - DISPLAY_GLYPH_FIRST + 1][DISPLAY_GLYPH_W] = {
+    GLYPH_AT('/') = GLYPH(0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00),
+    GLYPH_AT('0') = GLYPH(0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E),
+    GLYPH_AT('1') = GLYPH(0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E),
+    GLYPH_AT('2') = GLYPH(0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F),
+    GLYPH_AT('3') = GLYPH(0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E),
+    GLYPH_AT('4') = GLYPH(0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02),
+    GLYPH_AT('5') = GLYPH(0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E),
+    GLYPH_AT('6') = GLYPH(0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E),
+    GLYPH_AT('7') = GLYPH(0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08),
+    GLYPH_AT('8') = GLYPH(0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E),
+    GLYPH_AT('9') = GLYPH(0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C),
+    GLYPH_AT('A') = GLYPH(0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11),
+    GLYPH_AT('B') = GLYPH(0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E),
+    GLYPH_AT('C') = GLYPH(0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E),
+    GLYPH_AT('D') = GLYPH(0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C),
+    GLYPH_AT('E') = GLYPH(0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F),
+    GLYPH_AT('F') = GLYPH(0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10),
+    GLYPH_AT('G') = GLYPH(0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F),
+    GLYPH_AT('H') = GLYPH(0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11),
+    GLYPH_AT('I') = GLYPH(0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E),
+    GLYPH_AT('J') = GLYPH(0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C),
+    GLYPH_AT('K') = GLYPH(0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11),
+    GLYPH_AT('L') = GLYPH(0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F),
+    GLYPH_AT('M') = GLYPH(0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11),
+    GLYPH_AT('N') = GLYPH(0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11),
+    GLYPH_AT('O') = GLYPH(0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E),
+    GLYPH_AT('P') = GLYPH(0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10),
+    GLYPH_AT('R') = GLYPH(0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11),
+    GLYPH_AT('S') = GLYPH(0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E),
+    GLYPH_AT('T') = GLYPH(0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04),
+};
+
+#endif /* DISPLAY_GLYPHS_H */
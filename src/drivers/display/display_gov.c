@@ -0,0 +1,86 @@
+#include "drivers/display/display_gov.h"
+#include "drivers/display/display.h"
+
+#define GAP_MS (1000u / DISPLAY_GOV_FPS)
+
+static uint8_t s_pending = DISPLAY_PRIO_NONE; /* highest priority waiting */
+static bool s_holding = false;                /* urgent screen up, hold not over */
+static bool s_late = false;                   /* this slot already counted as dropped */
+static uint32_t s_last_ms = 0;                /* start of the last normal frame */
+static uint32_t s_hold_ms = 0;                /* start of the last urgent frame */
+static display_gov_stats_t s_stats;
+
+void display_gov_init(void)
+{
+    s_pending = DISPLAY_PRIO_NONE;
+    s_holding = false;
+    s_late = false;
+    s_last_ms = 0;
+    s_hold_ms = 0;
+    display_gov_stats_t zero = {0};
+    s_stats = zero;
+}
+
+void display_gov_post(display_prio_t prio, uint32_t n)
+{
+    if (prio == DISPLAY_PRIO_NONE || n == 0u)
+        return;
+
+    s_stats.changes += n;
+
+    /* one frame shows them all: every change but the one it is drawn for
+     * is coalesced. a screen of higher priority gets its own frame.
+     */
+    s_stats.coalesced += (s_pending >= (uint8_t) prio) ? n : n - 1u;
+    if ((uint8_t) prio > s_pending)
+        s_pending = (uint8_t) prio;
+}
+
+display_prio_t display_gov_next(uint32_t now_ms)
+{
+    if (s_pending == DISPLAY_PRIO_NONE)
+        return DISPLAY_PRIO_NONE;
+
+    if (s_holding && (now_ms - s_hold_ms) >= DISPLAY_GOV_HOLD_MS)
+        s_holding = false;
+
+    if (s_pending == DISPLAY_PRIO_NORMAL)
+    {
+        /* an urgent screen is up, or the rate cap: wait, changes keep folding in */
+        if (s_holding || (now_ms - s_last_ms) < GAP_MS)
+            return DISPLAY_PRIO_NONE;
+    }
+
+    if (display_busy())
+    {
+        if (!s_late)
+        {
+            s_late = true;
+            s_stats.dropped++;
+        }
+        return DISPLAY_PRIO_NONE;
+    }
+    s_late = false;
+
+    display_prio_t prio = (display_prio_t) s_pending;
+    s_stats.frames++;
+    if (prio == DISPLAY_PRIO_URGENT)
+    {
+        s_stats.urgent++;
+        s_holding = true;
+        s_hold_ms = now_ms;
+        /* bring the normal screen back once the hold is over */
+        s_pending = DISPLAY_PRIO_NORMAL;
+    }
+    else
+    {
+        s_last_ms = now_ms;
+        s_pending = DISPLAY_PRIO_NONE;
+    }
+    return prio;
+}
+
+display_gov_stats_t display_gov_get_stats(void)
+{
+    return s_stats;
+}
@@ -0,0 +1,55 @@
+#ifndef DISPLAY_GOV_H
+#define DISPLAY_GOV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* display update governor: decides when the main loop draws a frame
+ * - state changes are posted with a priority; changes that arrive while a
+ *   frame is pending fold into it (coalesced), so the display cost depends on
+ *   the frame rate, not on how fast seedlings pass
+ * - normal frames are at most DISPLAY_GOV_FPS per second; an urgent frame
+ *   (e.g. target reached) goes out at the next poll and then stays up for
+ *   DISPLAY_GOV_HOLD_MS, after which the normal screen comes back by itself
+ * - a frame is never started while the previous one is still on the wire;
+ *   a frame slot lost that way counts as dropped, the change stays pending
+ * main loop only; o(1) per call
+ */
+
+/* cap on normal frames per second */
+#ifndef DISPLAY_GOV_FPS
+#define DISPLAY_GOV_FPS 10u
+#endif
+
+/* how long an urgent screen stays up before normal frames resume (ms) */
+#ifndef DISPLAY_GOV_HOLD_MS
+#define DISPLAY_GOV_HOLD_MS 2000u
+#endif
+
+typedef enum
+{
+    DISPLAY_PRIO_NONE = 0, /* nothing to draw */
+    DISPLAY_PRIO_NORMAL,
+    DISPLAY_PRIO_URGENT
+} display_prio_t;
+
+typedef struct
+{
+    uint32_t changes;   /* state changes posted */
+    uint32_t frames;    /* frames drawn */
+    uint32_t urgent;    /* of which urgent */
+    uint32_t coalesced; /* changes folded into a frame drawn later */
+    uint32_t dropped;   /* frame slots lost to a busy display */
+} display_gov_stats_t;
+
+void display_gov_init(void);
+
+/* n state changes (n >= 1) that need a screen of priority prio */
+void display_gov_post(display_prio_t prio, uint32_t n);
+
+/* poll: the screen to draw now (the caller draws it), or DISPLAY_PRIO_NONE */
+display_prio_t display_gov_next(uint32_t now_ms);
+
+display_gov_stats_t display_gov_get_stats(void);
+
+#endif /* DISPLAY_GOV_H */
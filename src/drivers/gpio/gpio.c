@@ -1,8 +1,29 @@
 #include "gpio.h"
+#include "gpio_fast.h"
 
 /* internal error latch (not thread-safe; good enough for bare-metal) */
 static volatile int32_t s_last_error = 0;
 
+/* per-line callbacks set by gpio_attach_irq(); read by the exti vectors */
+typedef struct
+{
+    gpio_irq_fn_t fn;
+    void *ctx;
+} gpio_irq_slot_t;
+
+static gpio_irq_slot_t s_irq[16];
+
+/* line groups; s_group_lines is the union, checked first by the vectors */
+typedef struct
+{
+    gpio_irq_group_fn_t fn;
+    void *ctx;
+    uint16_t lines;
+} gpio_irq_group_t;
+
+static gpio_irq_group_t s_group[GPIO_IRQ_GROUPS];
+static volatile uint16_t s_group_lines = 0;
+
 /* enable the gpio clock that matches the given port */
 static void gpio_enable_clock(GPIO_TypeDef *port)
 {
@@ -144,8 +165,163 @@ __attribute__((weak)) void gpio_on_interrupt(uint16_t pin)
     /* user can implement this function to handle exti events */
 }
 
-/* hal callback → route to user hook */
+gpio_status_t gpio_attach_irq(uint16_t pin, gpio_irq_fn_t fn, void *ctx)
+{
+    if (!fn || pin == 0u || (pin & (pin - 1u)) != 0u)
+    {
+        s_last_error = -106;
+        return gpio_err;
+    }
+
+    gpio_irq_slot_t *s = &s_irq[__builtin_ctz(pin)];
+
+    /* fn and ctx change together with respect to the vector */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool taken = (s->fn != NULL && s->fn != fn) || (s_group_lines & pin) != 0u;
+    if (!taken)
+    {
+        s->fn = fn;
+        s->ctx = ctx;
+    }
+    __set_PRIMASK(primask);
+
+    if (taken)
+    {
+        s_last_error = -107;
+        return gpio_err;
+    }
+    return gpio_ok;
+}
+
+void gpio_detach_irq(uint16_t pin)
+{
+    if (pin == 0u || (pin & (pin - 1u)) != 0u)
+    {
+        s_last_error = -108;
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    s_irq[__builtin_ctz(pin)].fn = NULL;
+    s_irq[__builtin_ctz(pin)].ctx = NULL;
+    __set_PRIMASK(primask);
+}
+
+gpio_status_t gpio_attach_irq_group(uint16_t lines, gpio_irq_group_fn_t fn, void *ctx)
+{
+    if (!fn || lines == 0u)
+    {
+        s_last_error = -109;
+        return gpio_err;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bool taken = (s_group_lines & lines) != 0u;
+    for (uint32_t line = 0; line < 16u && !taken; line++)
+    {
+        taken = (lines & (1u << line)) && s_irq[line].fn != NULL;
+    }
+
+    gpio_irq_group_t *g = NULL;
+    for (uint32_t i = 0; i < GPIO_IRQ_GROUPS && !taken && !g; i++)
+    {
+        if (s_group[i].fn == NULL)
+            g = &s_group[i];
+    }
+    if (g)
+    {
+        g->fn = fn;
+        g->ctx = ctx;
+        g->lines = lines;
+        s_group_lines |= lines;
+    }
+    __set_PRIMASK(primask);
+
+    if (!g)
+    {
+        s_last_error = -110;
+        return gpio_err;
+    }
+    return gpio_ok;
+}
+
+void gpio_detach_irq_group(gpio_irq_group_fn_t fn)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < GPIO_IRQ_GROUPS; i++)
+    {
+        if (s_group[i].fn == fn)
+        {
+            s_group_lines &= (uint16_t) ~s_group[i].lines;
+            s_group[i] = (gpio_irq_group_t){0};
+        }
+    }
+    __set_PRIMASK(primask);
+}
+
+/* give the grouped part of pend to its owners; returns what is left */
+static uint32_t dispatch_groups(uint32_t pend)
+{
+    for (uint32_t i = 0; i < GPIO_IRQ_GROUPS && (pend & s_group_lines); i++)
+    {
+        const gpio_irq_group_t *g = &s_group[i];
+        uint32_t got = pend & g->lines;
+        if (got)
+        {
+            pend &= ~got;
+            g->fn((uint16_t) got, g->ctx);
+        }
+    }
+    return pend;
+}
+
+void gpio_exti_dispatch(uint32_t line)
+{
+    const gpio_irq_slot_t *s = &s_irq[line];
+    uint16_t pin = (uint16_t) (1u << line);
+
+    if (s_group_lines & pin)
+    {
+        (void) dispatch_groups(pin);
+    }
+    else if (s->fn)
+    {
+        s->fn(pin, s->ctx);
+    }
+    else
+    {
+        gpio_on_interrupt(pin);
+    }
+}
+
+void gpio_exti_demux(uint32_t mask)
+{
+    /* clear everything taken in one store; an edge during the callbacks re-pends
+     * its line and the vector runs again
+     */
+    uint32_t pend = EXTI->PR & EXTI->IMR & mask;
+    if (pend == 0u)
+    {
+        return;
+    }
+    GPIO_EXTI_CLEAR(pend);
+
+    pend = dispatch_groups(pend);
+    while (pend != 0u)
+    {
+        uint32_t line = (uint32_t) __builtin_ctz(pend);
+        pend &= pend - 1u;
+        gpio_exti_dispatch(line);
+    }
+}
+
+/* hal callback → per-line callback or user hook */
 void HAL_GPIO_EXTI_Callback(uint16_t pin)
 {
-    gpio_on_interrupt(pin);
+    gpio_exti_dispatch((uint32_t) __builtin_ctz(pin));
 }
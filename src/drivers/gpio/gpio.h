@@ -47,9 +47,46 @@ extern "C"
 
     /* user hook called from hal exti callback (weak default).
  * implement this in your application if you want to be notified on any gpio exti.
+ * lines with a callback from gpio_attach_irq() no longer reach it.
  */
     void gpio_on_interrupt(uint16_t pin);
 
+/* line groups for gpio_attach_irq_group() */
+#ifndef GPIO_IRQ_GROUPS
+#define GPIO_IRQ_GROUPS 2u
+#endif
+
+    /* per-line exti callback, isr context; pin is the line's bit (GPIO_PIN_x) */
+    typedef void (*gpio_irq_fn_t)(uint16_t pin, void *ctx);
+
+    /* route one exti line to fn(pin, ctx)
+ * - pin: a single GPIO_PIN_x; the line is shared by all ports, so one owner per line
+ * - fails if the line already has a different callback or belongs to a group
+ * - configure the pin itself with gpio_setup_input_irq()
+ */
+    gpio_status_t gpio_attach_irq(uint16_t pin, gpio_irq_fn_t fn, void *ctx);
+    void gpio_detach_irq(uint16_t pin);
+
+    /* group callback: lines = every pending line of the group, taken in one go */
+    typedef void (*gpio_irq_group_fn_t)(uint16_t lines, void *ctx);
+
+    /* hand a set of lines to one callback, so edges that pend together are seen
+ * together (e.g. one idr read for all of them)
+ * - at most GPIO_IRQ_GROUPS groups; lines must not be claimed yet
+ * - gpio_detach_irq_group(fn) releases the lines of that group
+ */
+    gpio_status_t gpio_attach_irq_group(uint16_t lines, gpio_irq_group_fn_t fn, void *ctx);
+    void gpio_detach_irq_group(gpio_irq_group_fn_t fn);
+
+    /* run the callback of one line (0..15), or gpio_on_interrupt() if none */
+    void gpio_exti_dispatch(uint32_t line);
+
+    /* body of an exti vector: clear every pending line in mask, hand grouped
+ * lines to their group, then the rest lowest line first
+ * (e.g. 0x03E0 for EXTI9_5, 0xFC00 for EXTI15_10)
+ */
+    void gpio_exti_demux(uint32_t mask);
+
 #ifdef __cplusplus
 }
 #endif
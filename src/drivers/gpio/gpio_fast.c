@@ -0,0 +1,43 @@
+#include "gpio_fast.h"
+#include "gpio.h"
+
+#if GPIO_EXTI_FAST
+
+/* unclaimed line: pr is already cleared, hand it to the registry */
+#define GPIO_FAST_WEAK(n)                                                                      \
+    static void gpio_fast_default##n(uint32_t idr)                                             \
+    {                                                                                          \
+        (void) idr;                                                                            \
+        gpio_exti_dispatch(n);                                                                 \
+    }                                                                                          \
+    void gpio_fast_line##n(uint32_t idr) __attribute__((weak, alias("gpio_fast_default" #n)));
+
+GPIO_FAST_WEAK(0)
+GPIO_FAST_WEAK(1)
+GPIO_FAST_WEAK(2)
+GPIO_FAST_WEAK(3)
+GPIO_FAST_WEAK(4)
+GPIO_FAST_WEAK(5)
+GPIO_FAST_WEAK(6)
+GPIO_FAST_WEAK(7)
+GPIO_FAST_WEAK(8)
+GPIO_FAST_WEAK(9)
+GPIO_FAST_WEAK(10)
+GPIO_FAST_WEAK(11)
+GPIO_FAST_WEAK(12)
+GPIO_FAST_WEAK(13)
+GPIO_FAST_WEAK(14)
+GPIO_FAST_WEAK(15)
+
+/* resolved by the linker, lives in flash */
+const gpio_fast_fn_t gpio_fast_table[16] = {
+    gpio_fast_line0,  gpio_fast_line1,  gpio_fast_line2,  gpio_fast_line3,
+    gpio_fast_line4,  gpio_fast_line5,  gpio_fast_line6,  gpio_fast_line7,
+    gpio_fast_line8,  gpio_fast_line9,  gpio_fast_line10, gpio_fast_line11,
+    gpio_fast_line12, gpio_fast_line13, gpio_fast_line14, gpio_fast_line15,
+};
+
+/* afio exticr port code → port (0 = a .. 4 = e) */
+GPIO_TypeDef *const gpio_fast_ports[5] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOE};
+
+#endif /* GPIO_EXTI_FAST */
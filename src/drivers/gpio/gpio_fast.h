@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include "stm32f1xx_hal.h"
+
+/* direct-register exti dispatch (GPIO_EXTI_FAST=1)
+ * - the vector clears its exti->pr bit with one store, reads the port idr
+ *   once and calls a per-line handler from a const table in flash
+ * - no HAL_GPIO_EXTI_IRQHandler / HAL_GPIO_EXTI_Callback / pin switch on the way
+ * - a driver claims line n by defining gpio_fast_lineN(idr); unclaimed lines
+ *   resolve at link time to a weak default that hands the line to
+ *   gpio_exti_dispatch() (gpio_attach_irq() callback or gpio_on_interrupt())
+ * - the port comes from afio->exticr, so handlers see the idr of the port
+ *   their line is routed to
+ *
+ * with GPIO_EXTI_FAST=0 the vectors keep the hal path and gpio_on_interrupt()
+ */
+
+#ifndef GPIO_EXTI_FAST
+#define GPIO_EXTI_FAST 0
+#endif
+
+/* exti->pr is rc_w1 on the target; the sim models it as a plain register */
+#ifdef SPROUT_SIM
+#define GPIO_EXTI_CLEAR(mask) (EXTI->PR &= ~(uint32_t) (mask))
+#else
+#define GPIO_EXTI_CLEAR(mask) (EXTI->PR = (uint32_t) (mask))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if GPIO_EXTI_FAST
+
+    /* idr = snapshot of the line's port input register, taken after the clear */
+    typedef void (*gpio_fast_fn_t)(uint32_t idr);
+
+    extern const gpio_fast_fn_t gpio_fast_table[16];
+    extern GPIO_TypeDef *const gpio_fast_ports[5];
+
+    /* per-line handlers (weak, fall back to gpio_exti_dispatch()) */
+    void gpio_fast_line0(uint32_t idr);
+    void gpio_fast_line1(uint32_t idr);
+    void gpio_fast_line2(uint32_t idr);
+    void gpio_fast_line3(uint32_t idr);
+    void gpio_fast_line4(uint32_t idr);
+    void gpio_fast_line5(uint32_t idr);
+    void gpio_fast_line6(uint32_t idr);
+    void gpio_fast_line7(uint32_t idr);
+    void gpio_fast_line8(uint32_t idr);
+    void gpio_fast_line9(uint32_t idr);
+    void gpio_fast_line10(uint32_t idr);
+    void gpio_fast_line11(uint32_t idr);
+    void gpio_fast_line12(uint32_t idr);
+    void gpio_fast_line13(uint32_t idr);
+    void gpio_fast_line14(uint32_t idr);
+    void gpio_fast_line15(uint32_t idr);
+
+    /* body of a dedicated exti vector (lines 0..4); line must be a constant
+     * so the shifts and the table slot fold at compile time.
+     * pr is cleared before idr is read: an edge that lands after the read
+     * re-pends the line and the vector runs again with the new level.
+     */
+    static inline void gpio_exti_fast(uint32_t line)
+    {
+        GPIO_EXTI_CLEAR(1u << line);
+        uint32_t port = (AFIO->EXTICR[line >> 2] >> ((line & 3u) << 2)) & 0xFu;
+        gpio_fast_table[line](gpio_fast_ports[port]->IDR);
+    }
+
+#endif /* GPIO_EXTI_FAST */
+
+#ifdef __cplusplus
+}
+#endif
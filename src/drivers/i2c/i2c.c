@@ -1,8 +1,13 @@
 #include "drivers/i2c/i2c.h"
+#include "drivers/prof/prof.h"
 #include "stm32f1xx_hal_gpio.h"
 #include "stm32f1xx_hal_rcc.h"
 #include <string.h>
 
+/* bus handles by instance, for routing interrupts and hal callbacks */
+static i2c_bus_t *s_bus_i2c1 = NULL;
+static i2c_bus_t *s_bus_i2c2 = NULL;
+
 /* internal helpers */
 static i2c_status_t _map_hal(HAL_StatusTypeDef s)
 {
@@ -72,24 +77,240 @@ static void _configure_pins(const i2c_config_t *cfg)
     }
 }
 
-i2c_status_t i2c_init(i2c_bus_t *bus, const i2c_config_t *cfg)
+static i2c_bus_t *_bus_of(I2C_TypeDef *instance)
 {
-    if (!bus || !cfg || (cfg->instance != I2C1 && cfg->instance != I2C2))
-        return I2C_ST_PARAM;
+    return (instance == I2C1) ? s_bus_i2c1 : (instance == I2C2) ? s_bus_i2c2 : NULL;
+}
 
-    memset(bus, 0, sizeof(*bus));
-    bus->cfg = *cfg;
+static i2c_bus_t *_bus_of_hal(I2C_HandleTypeDef *hi2c)
+{
+    return hi2c ? _bus_of(hi2c->Instance) : NULL;
+}
+
+/* tx dma channel: i2c1 → dma1 ch6, i2c2 → dma1 ch4 */
+static HAL_StatusTypeDef _configure_dma(i2c_bus_t *bus)
+{
+    bool is_i2c1 = (bus->cfg.instance == I2C1);
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    bus->hdma_tx.Instance = is_i2c1 ? DMA1_Channel6 : DMA1_Channel4;
+    bus->hdma_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    bus->hdma_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+    bus->hdma_tx.Init.MemInc = DMA_MINC_ENABLE;
+    bus->hdma_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    bus->hdma_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    bus->hdma_tx.Init.Mode = DMA_NORMAL;
+    bus->hdma_tx.Init.Priority = DMA_PRIORITY_LOW;
+
+    HAL_StatusTypeDef st = HAL_DMA_Init(&bus->hdma_tx);
+    if (st != HAL_OK)
+        return st;
+    __HAL_LINKDMA(&bus->hi2c, hdmatx, bus->hdma_tx);
+
+    /* below the ir lines (10) so counting is never held off by bus traffic */
+    IRQn_Type dma_irq = is_i2c1 ? DMA1_Channel6_IRQn : DMA1_Channel4_IRQn;
+    IRQn_Type ev_irq = is_i2c1 ? I2C1_EV_IRQn : I2C2_EV_IRQn;
+    IRQn_Type er_irq = is_i2c1 ? I2C1_ER_IRQn : I2C2_ER_IRQn;
+    HAL_NVIC_SetPriority(dma_irq, 12, 0);
+    HAL_NVIC_EnableIRQ(dma_irq);
+    HAL_NVIC_SetPriority(ev_irq, 12, 0);
+    HAL_NVIC_EnableIRQ(ev_irq);
+    HAL_NVIC_SetPriority(er_irq, 12, 0);
+    HAL_NVIC_EnableIRQ(er_irq);
+
+    return HAL_OK;
+}
+
+/* ---- transfer engine ------------------------------------------------------
+ * submit() puts a slot index in the fifo; _kick() moves the head onto the wire
+ * when the bus is idle. completion callbacks (isr) finish the slot and kick
+ * the next one, so the cpu never waits for the bus.
+ */
+
+#define XFER_IDLE 0xFFu
+
+enum
+{
+    XFER_FREE = 0,
+    XFER_QUEUED,
+    XFER_ACTIVE,
+    XFER_DONE
+};
+
+static inline i2c_xfer_t _handle(const i2c_bus_t *bus, uint8_t idx)
+{
+    return (i2c_xfer_t) (((uint16_t) bus->pool[idx].gen << 8) | idx);
+}
+
+/* start the active slot's first phase; false if the hal refused */
+static HAL_StatusTypeDef _start(i2c_bus_t *bus, i2c_xfer_slot_t *x)
+{
+    uint16_t addr = (uint16_t) (x->addr7 << 1);
+
+    if (x->wlen && x->rlen)
+    {
+        /* no stop after the write: the read phase follows with a repeated start */
+        return HAL_I2C_Master_Seq_Transmit_IT(
+                &bus->hi2c, addr, (uint8_t *) x->wbuf, x->wlen, I2C_FIRST_FRAME);
+    }
+    if (x->rlen)
+    {
+        return HAL_I2C_Master_Receive_IT(&bus->hi2c, addr, x->rbuf, x->rlen);
+    }
+    if (x->wlen >= 2u)
+    {
+        return HAL_I2C_Master_Transmit_DMA(&bus->hi2c, addr, (uint8_t *) x->wbuf, x->wlen);
+    }
+    /* f1 dma cannot do single-byte (or empty) writes; short ones go by interrupt */
+    return HAL_I2C_Master_Transmit_IT(&bus->hi2c, addr, (uint8_t *) x->wbuf, x->wlen);
+}
+
+static void _complete(i2c_bus_t *bus, uint8_t idx, i2c_status_t st);
+
+/* open the breaker (isr or thread) */
+static void _trip(i2c_bus_t *bus)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (bus->health == I2C_HEALTH_OK)
+    {
+        bus->health = I2C_HEALTH_STUCK;
+        bus->rec.stuck++;
+    }
+    __set_PRIMASK(primask);
+}
+
+/* the bus is idle here, so busy should drop within a stop condition */
+static bool _bus_stuck(const i2c_bus_t *bus)
+{
+    /* crude: ~4 cycles per turn */
+    uint32_t n = I2C_BUSY_WAIT_US * (SystemCoreClock / 1000000u) / 4u;
+    while (bus->hi2c.Instance->SR2 & I2C_SR2_BUSY)
+    {
+        if (n-- == 0u)
+            return true;
+    }
+    return false;
+}
+
+/* tick after which the transfer is taken as hung: twice its bit time + margin */
+static uint32_t _deadline(const i2c_bus_t *bus, const i2c_xfer_slot_t *x)
+{
+    uint32_t hz = bus->cfg.clock_speed_hz ? bus->cfg.clock_speed_hz : 400000U;
+    uint32_t bits = ((uint32_t) x->wlen + x->rlen + 2u) * 9u;
+    return HAL_GetTick() + 2u * (bits * 1000u / hz + 1u) + I2C_XFER_MARGIN_MS;
+}
+
+static void _kick(i2c_bus_t *bus)
+{
+    for (;;)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        if (bus->active != XFER_IDLE || bus->fifo_head == bus->fifo_tail)
+        {
+            __set_PRIMASK(primask);
+            return;
+        }
+        uint8_t idx = bus->fifo[bus->fifo_tail & (I2C_XFER_POOL - 1u)];
+        bus->fifo_tail++;
+        bus->active = idx;
+        bus->pool[idx].state = XFER_ACTIVE;
+        __set_PRIMASK(primask);
+
+        if (bus->pool[idx].cancel)
+        {
+            _complete(bus, idx, I2C_ST_TIMEOUT);
+            continue;
+        }
+
+        /* checked here rather than by the hal, which spins up to 25 ms on busy */
+        if (bus->health != I2C_HEALTH_OK || _bus_stuck(bus))
+        {
+            _trip(bus);
+            _complete(bus, idx, I2C_ST_BUSERR);
+            continue;
+        }
+
+        bus->deadline_ms = _deadline(bus, &bus->pool[idx]);
+        HAL_StatusTypeDef st = _start(bus, &bus->pool[idx]);
+        if (st == HAL_OK)
+            return;
+
+        /* refused outright: report it and try the next one */
+        _complete(bus, idx, _map_hal(st));
+    }
+}
+
+/* active slot is done: report, recycle or park it, then start the next */
+static void _complete(i2c_bus_t *bus, uint8_t idx, i2c_status_t st)
+{
+    i2c_xfer_slot_t *x = &bus->pool[idx];
+    i2c_done_cb_t cb = x->cb;
+    void *ctx = x->ctx;
+
+    x->st = (uint8_t) st;
+    if (cb)
+    {
+        x->cb = NULL;
+        x->state = XFER_FREE;
+    }
+    else
+    {
+        x->state = XFER_DONE; /* until i2c_poll() picks it up */
+    }
+    bus->active = XFER_IDLE;
+
+    /* callback may submit the next transfer right away */
+    if (cb)
+        cb(bus, st, ctx);
+
+    _kick(bus);
+}
+
+/* a hal callback for the bus: finish or advance the active slot */
+static void _on_event(I2C_HandleTypeDef *hi2c, bool rx, i2c_status_t st)
+{
+    i2c_bus_t *bus = _bus_of_hal(hi2c);
+    if (!bus || bus->active == XFER_IDLE)
+        return;
+
+    uint8_t idx = bus->active;
+    i2c_xfer_slot_t *x = &bus->pool[idx];
+
+    if (st == I2C_ST_OK && !rx && x->rlen)
+    {
+        /* write phase of a write-read done: repeated start into the read */
+        HAL_StatusTypeDef hs = HAL_I2C_Master_Seq_Receive_IT(
+                &bus->hi2c, (uint16_t) (x->addr7 << 1), x->rbuf, x->rlen, I2C_LAST_FRAME);
+        if (hs == HAL_OK)
+            return;
+        st = _map_hal(hs);
+    }
+
+    _complete(bus, idx, st);
+}
+
+/* peripheral, pins and dma from bus->cfg; the transfer engine is untouched */
+static i2c_status_t _setup(i2c_bus_t *bus)
+{
+    const i2c_config_t *cfg = &bus->cfg;
 
     _enable_clocks(cfg);
     _configure_pins(cfg);
 
+    /* software reset clears a busy flag latched by noise on the lines (f1 errata) */
+    cfg->instance->CR1 |= I2C_CR1_SWRST;
+    cfg->instance->CR1 &= ~I2C_CR1_SWRST;
+
     /* deinit before init to ensure a clean state */
     bus->hi2c.Instance = cfg->instance;
     (void) HAL_I2C_DeInit(&bus->hi2c);
 
     /* f1 init fields */
     bus->hi2c.Init.ClockSpeed = cfg->clock_speed_hz ? cfg->clock_speed_hz : 400000U;
-    bus->hi2c.Init.DutyCycle = I2C_DUTYCYCLE_2;
+    bus->hi2c.Init.DutyCycle = (cfg->duty == I2C_DUTY_16_9) ? I2C_DUTYCYCLE_16_9 : I2C_DUTYCYCLE_2;
     bus->hi2c.Init.OwnAddress1 = 0x00;
     bus->hi2c.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
     bus->hi2c.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
@@ -101,27 +322,167 @@ i2c_status_t i2c_init(i2c_bus_t *bus, const i2c_config_t *cfg)
     if (st != HAL_OK)
         return _map_hal(st);
 
+    if (cfg->instance == I2C1)
+        s_bus_i2c1 = bus;
+    else
+        s_bus_i2c2 = bus;
+
+    st = _configure_dma(bus);
+    if (st != HAL_OK)
+        return _map_hal(st);
+
     bus->ready = true;
     return I2C_ST_OK;
 }
 
+i2c_status_t i2c_init(i2c_bus_t *bus, const i2c_config_t *cfg)
+{
+    if (!bus || !cfg || (cfg->instance != I2C1 && cfg->instance != I2C2))
+        return I2C_ST_PARAM;
+
+    memset(bus, 0, sizeof(*bus));
+    bus->cfg = *cfg;
+    bus->active = XFER_IDLE;
+    bus->health = I2C_HEALTH_OK;
+
+    return _setup(bus);
+}
+
+i2c_status_t i2c_submit(i2c_bus_t *bus,
+                        uint8_t addr7,
+                        const uint8_t *wbuf,
+                        size_t wlen,
+                        uint8_t *rbuf,
+                        size_t rlen,
+                        i2c_done_cb_t cb,
+                        void *ctx,
+                        i2c_xfer_t *out)
+{
+    if (out)
+        *out = I2C_XFER_NONE;
+    if (!bus || !bus->ready || (addr7 > 0x7f) || (wlen && !wbuf) || (rlen && !rbuf) ||
+        (wlen > 0xFFFFU) || (rlen > 0xFFFFU))
+        return I2C_ST_PARAM;
+    if (bus->health != I2C_HEALTH_OK)
+        return I2C_ST_BUSERR;
+
+    /* callers may be isrs (completion callbacks chain transfers) */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uint8_t idx = 0;
+    while (idx < I2C_XFER_POOL && bus->pool[idx].state != XFER_FREE)
+        idx++;
+    if (idx == I2C_XFER_POOL)
+    {
+        __set_PRIMASK(primask);
+        return I2C_ST_BUSY;
+    }
+
+    i2c_xfer_slot_t *x = &bus->pool[idx];
+    x->wbuf = wbuf;
+    x->rbuf = rbuf;
+    x->wlen = (uint16_t) wlen;
+    x->rlen = (uint16_t) rlen;
+    x->addr7 = addr7;
+    x->gen++;
+    x->st = I2C_ST_BUSY;
+    x->cb = cb;
+    x->ctx = ctx;
+    x->cancel = false;
+    x->state = XFER_QUEUED;
+
+    bus->fifo[bus->fifo_head & (I2C_XFER_POOL - 1u)] = idx;
+    bus->fifo_head++;
+
+    if (out)
+        *out = _handle(bus, idx);
+    __set_PRIMASK(primask);
+
+    _kick(bus);
+    return I2C_ST_OK;
+}
+
+i2c_status_t i2c_poll(i2c_bus_t *bus, i2c_xfer_t h)
+{
+    uint8_t idx = (uint8_t) (h & 0xFFu);
+    if (!bus || h == I2C_XFER_NONE || idx >= I2C_XFER_POOL)
+        return I2C_ST_PARAM;
+
+    i2c_xfer_slot_t *x = &bus->pool[idx];
+    if (x->gen != (uint8_t) (h >> 8) || x->cb || x->state == XFER_FREE)
+        return I2C_ST_PARAM;
+    if (x->state != XFER_DONE)
+        return I2C_ST_BUSY;
+
+    i2c_status_t st = (i2c_status_t) x->st;
+    x->state = XFER_FREE;
+    return st;
+}
+
+/* completion sink for abandoned transfers: having a callback recycles the slot */
+static void _drop(i2c_bus_t *bus, i2c_status_t st, void *ctx)
+{
+    (void) bus;
+    (void) st;
+    (void) ctx;
+}
+
+/* a blocking call timed out: nobody will poll its slot any more */
+static void _abandon(i2c_bus_t *bus, i2c_xfer_t h)
+{
+    i2c_xfer_slot_t *x = &bus->pool[h & 0xFFu];
+    bool active = false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (x->state == XFER_DONE)
+    {
+        x->state = XFER_FREE;
+    }
+    else
+    {
+        x->cb = _drop;
+        x->ctx = NULL;
+        x->cancel = (x->state == XFER_QUEUED);
+        active = (x->state == XFER_ACTIVE);
+    }
+    __set_PRIMASK(primask);
+
+    if (active)
+    {
+        /* the caller's buffer goes out of scope: cut the transfer short */
+        (void) HAL_I2C_Master_Abort_IT(&bus->hi2c, (uint16_t) (x->addr7 << 1));
+    }
+}
+
+static i2c_status_t _wait(i2c_bus_t *bus, i2c_xfer_t h, uint32_t timeout_ms)
+{
+    uint32_t t0 = HAL_GetTick();
+    for (;;)
+    {
+        i2c_status_t st = i2c_poll(bus, h);
+        if (st != I2C_ST_BUSY)
+            return st;
+        if ((HAL_GetTick() - t0) >= timeout_ms)
+        {
+            _abandon(bus, h);
+            return I2C_ST_TIMEOUT;
+        }
+    }
+}
+
 i2c_status_t
 i2c_write(i2c_bus_t *bus, uint8_t addr7, const uint8_t *data, size_t len, uint32_t timeout_ms)
 {
-    if (!bus || !bus->ready || (addr7 > 0x7f) || (len && !data))
-        return I2C_ST_PARAM;
-    HAL_StatusTypeDef st = HAL_I2C_Master_Transmit(
-            &bus->hi2c, (uint16_t) (addr7 << 1), (uint8_t *) data, (uint16_t) len, timeout_ms);
-    return _map_hal(st);
+    PROF_SCOPE(i2c_write);
+
+    return i2c_write_read(bus, addr7, data, len, NULL, 0, timeout_ms);
 }
 
 i2c_status_t i2c_read(i2c_bus_t *bus, uint8_t addr7, uint8_t *data, size_t len, uint32_t timeout_ms)
 {
-    if (!bus || !bus->ready || (addr7 > 0x7f) || (len && !data))
-        return I2C_ST_PARAM;
-    HAL_StatusTypeDef st = HAL_I2C_Master_Receive(
-            &bus->hi2c, (uint16_t) (addr7 << 1), data, (uint16_t) len, timeout_ms);
-    return _map_hal(st);
+    return i2c_write_read(bus, addr7, NULL, 0, data, len, timeout_ms);
 }
 
 i2c_status_t i2c_write_read(i2c_bus_t *bus,
@@ -131,37 +492,219 @@ i2c_status_t i2c_write_read(i2c_bus_t *bus,
                             uint8_t *rbuf,
                             size_t rlen,
                             uint32_t timeout_ms)
+{
+    i2c_xfer_t h;
+    i2c_status_t st = i2c_submit(bus, addr7, wbuf, wlen, rbuf, rlen, NULL, NULL, &h);
+    if (st != I2C_ST_OK)
+        return st;
+    return _wait(bus, h, timeout_ms);
+}
+
+i2c_status_t i2c_is_ready(i2c_bus_t *bus, uint8_t addr7, uint8_t trials, uint32_t timeout_ms)
 {
     if (!bus || !bus->ready || (addr7 > 0x7f))
         return I2C_ST_PARAM;
+    if (i2c_busy(bus))
+        return I2C_ST_BUSY;
+    HAL_StatusTypeDef st = HAL_I2C_IsDeviceReady(
+            &bus->hi2c, (uint16_t) (addr7 << 1), trials ? trials : 1, timeout_ms);
+    return _map_hal(st);
+}
+
+i2c_status_t i2c_write_dma(i2c_bus_t *bus,
+                           uint8_t addr7,
+                           const uint8_t *data,
+                           size_t len,
+                           i2c_done_cb_t cb,
+                           void *ctx)
+{
+    PROF_SCOPE(i2c_write_dma);
+
+    if (!data || !len)
+        return I2C_ST_PARAM;
+    return i2c_submit(bus, addr7, data, len, NULL, 0, cb, ctx, NULL);
+}
+
+bool i2c_busy(const i2c_bus_t *bus)
+{
+    return bus && (bus->active != XFER_IDLE || bus->fifo_head != bus->fifo_tail);
+}
 
-    HAL_StatusTypeDef st;
-    if (wlen)
+/* ---- stuck-bus recovery --------------------------------------------------- */
+
+/* about half an scl period at 100 khz; crude like the u8x8 delay */
+static void _half_bit(void)
+{
+    volatile uint32_t n = (SystemCoreClock / 1000000u) * 5u / 4u;
+    while (n--)
     {
-        if (!wbuf)
-            return I2C_ST_PARAM;
-        st = HAL_I2C_Master_Transmit(
-                &bus->hi2c, (uint16_t) (addr7 << 1), (uint8_t *) wbuf, (uint16_t) wlen, timeout_ms);
-        if (st != HAL_OK)
-            return _map_hal(st);
+        __NOP();
     }
-    if (rlen)
+}
+
+static inline void _line(GPIO_TypeDef *port, uint16_t pin, bool high)
+{
+    HAL_GPIO_WritePin(port, pin, high ? GPIO_PIN_SET : GPIO_PIN_RESET);
+    _half_bit();
+}
+
+/* a slave holding sda low is in the middle of a byte it is sending (or an
+ * ack): up to 9 clocks take it to the end, where it lets go. a stop then
+ * resets every slave. true if both lines are high afterwards
+ */
+static bool _unstick(const i2c_config_t *cfg)
+{
+    GPIO_InitTypeDef pin = {0};
+    pin.Mode = GPIO_MODE_OUTPUT_OD;
+    pin.Speed = GPIO_SPEED_FREQ_HIGH;
+    pin.Pull = GPIO_NOPULL;
+
+    HAL_GPIO_WritePin(cfg->scl_port, cfg->scl_pin, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(cfg->sda_port, cfg->sda_pin, GPIO_PIN_SET);
+    pin.Pin = cfg->scl_pin;
+    HAL_GPIO_Init(cfg->scl_port, &pin);
+    pin.Pin = cfg->sda_pin;
+    HAL_GPIO_Init(cfg->sda_port, &pin);
+    _half_bit();
+
+    for (uint32_t i = 0; i < 9u; i++)
     {
-        if (!rbuf)
-            return I2C_ST_PARAM;
-        st = HAL_I2C_Master_Receive(
-                &bus->hi2c, (uint16_t) (addr7 << 1), rbuf, (uint16_t) rlen, timeout_ms);
-        if (st != HAL_OK)
-            return _map_hal(st);
+        if (HAL_GPIO_ReadPin(cfg->sda_port, cfg->sda_pin) == GPIO_PIN_SET)
+            break;
+        _line(cfg->scl_port, cfg->scl_pin, false);
+        _line(cfg->scl_port, cfg->scl_pin, true);
     }
-    return I2C_ST_OK;
+
+    /* stop: sda rises while scl is high */
+    _line(cfg->scl_port, cfg->scl_pin, false);
+    _line(cfg->sda_port, cfg->sda_pin, false);
+    _line(cfg->scl_port, cfg->scl_pin, true);
+    _line(cfg->sda_port, cfg->sda_pin, true);
+
+    return HAL_GPIO_ReadPin(cfg->sda_port, cfg->sda_pin) == GPIO_PIN_SET &&
+           HAL_GPIO_ReadPin(cfg->scl_port, cfg->scl_pin) == GPIO_PIN_SET;
 }
 
-i2c_status_t i2c_is_ready(i2c_bus_t *bus, uint8_t addr7, uint8_t trials, uint32_t timeout_ms)
+i2c_status_t i2c_recover(i2c_bus_t *bus)
 {
-    if (!bus || !bus->ready || (addr7 > 0x7f))
+    if (!bus || !bus->ready)
         return I2C_ST_PARAM;
-    HAL_StatusTypeDef st = HAL_I2C_IsDeviceReady(
-            &bus->hi2c, (uint16_t) (addr7 << 1), trials ? trials : 1, timeout_ms);
-    return _map_hal(st);
+
+    PROF_SCOPE(i2c_recover);
+
+    /* breaker open first: nothing new reaches the hal from here */
+    _trip(bus);
+
+    /* stop the engine's interrupt sources before touching its slots */
+    bool is_i2c1 = (bus->cfg.instance == I2C1);
+    HAL_NVIC_DisableIRQ(is_i2c1 ? DMA1_Channel6_IRQn : DMA1_Channel4_IRQn);
+    HAL_NVIC_DisableIRQ(is_i2c1 ? I2C1_EV_IRQn : I2C2_EV_IRQn);
+    HAL_NVIC_DisableIRQ(is_i2c1 ? I2C1_ER_IRQn : I2C2_ER_IRQn);
+    (void) HAL_DMA_DeInit(&bus->hdma_tx);
+    (void) HAL_I2C_DeInit(&bus->hi2c);
+
+    /* fail the transfer on the wire; _kick() fails the queued ones */
+    if (bus->active != XFER_IDLE)
+        _complete(bus, bus->active, I2C_ST_BUSERR);
+    else
+        _kick(bus);
+
+    i2c_status_t st = _unstick(&bus->cfg) ? _setup(bus) : I2C_ST_BUSERR;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (st == I2C_ST_OK)
+    {
+        bus->health = I2C_HEALTH_OK;
+        bus->rec.recovered++;
+    }
+    else
+    {
+        bus->health = I2C_HEALTH_DOWN;
+        bus->retry_ms = HAL_GetTick() + I2C_RECOVER_RETRY_MS;
+        bus->rec.failed++;
+    }
+    __set_PRIMASK(primask);
+    return st;
+}
+
+void i2c_service(i2c_bus_t *bus)
+{
+    if (!bus || !bus->ready)
+        return;
+
+    uint32_t now = HAL_GetTick();
+    if (bus->health == I2C_HEALTH_OK)
+    {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        bool hung = bus->active != XFER_IDLE && (int32_t) (now - bus->deadline_ms) > 0;
+        __set_PRIMASK(primask);
+        if (!hung)
+            return;
+        _trip(bus);
+    }
+    else if (bus->health == I2C_HEALTH_DOWN && (int32_t) (now - bus->retry_ms) < 0)
+    {
+        return;
+    }
+
+    (void) i2c_recover(bus);
+}
+
+bool i2c_ok(const i2c_bus_t *bus)
+{
+    return bus && bus->ready && bus->health == I2C_HEALTH_OK;
+}
+
+i2c_recovery_stats_t i2c_get_recovery(const i2c_bus_t *bus)
+{
+    i2c_recovery_stats_t r = {0};
+    if (bus)
+        r = bus->rec;
+    return r;
+}
+
+/* ---- interrupt routing ---------------------------------------------------- */
+
+void i2c_ev_irq(I2C_TypeDef *instance)
+{
+    i2c_bus_t *bus = _bus_of(instance);
+    if (bus)
+        HAL_I2C_EV_IRQHandler(&bus->hi2c);
+}
+
+void i2c_er_irq(I2C_TypeDef *instance)
+{
+    i2c_bus_t *bus = _bus_of(instance);
+    if (bus)
+        HAL_I2C_ER_IRQHandler(&bus->hi2c);
+}
+
+void i2c_dma_tx_irq(I2C_TypeDef *instance)
+{
+    i2c_bus_t *bus = _bus_of(instance);
+    if (bus)
+        HAL_DMA_IRQHandler(&bus->hdma_tx);
+}
+
+/* hal completion callbacks (weak in the hal) */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    _on_event(hi2c, false, I2C_ST_OK);
+}
+
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    _on_event(hi2c, true, I2C_ST_OK);
+}
+
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    _on_event(hi2c, false, I2C_ST_HALERR);
+}
+
+void HAL_I2C_AbortCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    _on_event(hi2c, false, I2C_ST_HALERR);
 }
@@ -18,14 +18,27 @@ extern "C"
         I2C_ST_BUSY,
         I2C_ST_TIMEOUT,
         I2C_ST_PARAM,
-        I2C_ST_HALERR
+        I2C_ST_HALERR,
+        I2C_ST_BUSERR /* bus stuck: failed, or refused until it is recovered */
     } i2c_status_t;
 
+    /* fast-mode scl duty cycle (tlow:thigh); ignored at 100 khz and below.
+ * the scl divider is pclk1 / (3 x ccr) for 2:1 and pclk1 / (25 x ccr) for
+ * 16:9, so which one gets closer to the requested clock depends on pclk1:
+ * at 36 mhz 2:1 gives exactly 400 khz while 16:9 rounds down to 360 khz
+ */
+    typedef enum
+    {
+        I2C_DUTY_2 = 0, /* tlow = 2 x thigh */
+        I2C_DUTY_16_9   /* tlow = 16/9 x thigh; exact 400 khz needs pclk1 a multiple of 10 mhz */
+    } i2c_duty_t;
+
     /* configuration for an i2c bus instance */
     typedef struct
     {
         I2C_TypeDef *instance;   /* I2C1 or I2C2 */
         uint32_t clock_speed_hz; /* 100k/400k typical */
+        i2c_duty_t duty;         /* fast mode only */
         GPIO_TypeDef *scl_port;
         uint16_t scl_pin;
         GPIO_TypeDef *sda_port;
@@ -33,16 +46,123 @@ extern "C"
         bool i2c1_remap; /* true = remap i2c1 to pb8/pb9; ignored for i2c2 */
     } i2c_config_t;
 
-    /* handle holding hal handle + copy of config */
+    typedef struct i2c_bus i2c_bus_t;
+
+    /* completion callback for queued transfers; runs in interrupt context */
+    typedef void (*i2c_done_cb_t)(i2c_bus_t *bus, i2c_status_t st, void *ctx);
+
+/* transfer slots per bus (power of two, at most 128) */
+#ifndef I2C_XFER_POOL
+#define I2C_XFER_POOL 8u
+#endif
+
+#if (I2C_XFER_POOL & (I2C_XFER_POOL - 1u)) != 0u || I2C_XFER_POOL > 128u
+#error "I2C_XFER_POOL must be a power of two up to 128"
+#endif
+
+/* sr2.busy may outlast a stop by a few us; set longer with the bus idle, a
+ * slave is holding sda
+ */
+#ifndef I2C_BUSY_WAIT_US
+#define I2C_BUSY_WAIT_US 100u
+#endif
+
+/* a transfer on the wire longer than twice its length at the bus clock plus
+ * this margin is hung
+ */
+#ifndef I2C_XFER_MARGIN_MS
+#define I2C_XFER_MARGIN_MS 10u
+#endif
+
+/* pause between recovery attempts while the bus stays down */
+#ifndef I2C_RECOVER_RETRY_MS
+#define I2C_RECOVER_RETRY_MS 100u
+#endif
+
+    /* circuit breaker: transfers only run while the bus is ok */
+    typedef enum
+    {
+        I2C_HEALTH_OK = 0,
+        I2C_HEALTH_STUCK, /* stuck bus seen, recovery pending */
+        I2C_HEALTH_DOWN   /* recovery failed, retried every I2C_RECOVER_RETRY_MS */
+    } i2c_health_t;
+
     typedef struct
+    {
+        uint32_t stuck;     /* stuck bus or hung transfer detected */
+        uint32_t recovered; /* recoveries that freed the bus */
+        uint32_t failed;    /* recoveries that did not */
+    } i2c_recovery_stats_t;
+
+/* handle of a queued transfer: slot index + reuse generation */
+#define I2C_XFER_NONE 0xFFFFu
+    typedef uint16_t i2c_xfer_t;
+
+    /* one queued transfer; owned by the engine between submit and completion */
+    typedef struct
+    {
+        const uint8_t *wbuf;
+        uint8_t *rbuf;
+        uint16_t wlen;
+        uint16_t rlen;
+        uint8_t addr7;
+        uint8_t gen;            /* bumped on every reuse of the slot */
+        volatile uint8_t state; /* free / queued / active / done */
+        volatile uint8_t st;    /* i2c_status_t once done */
+        volatile bool cancel;   /* given up while queued: completes without touching the bus */
+        i2c_done_cb_t cb;
+        void *ctx;
+    } i2c_xfer_slot_t;
+
+    /* handle holding hal handle + copy of config */
+    struct i2c_bus
     {
         I2C_HandleTypeDef hi2c;
+        DMA_HandleTypeDef hdma_tx; /* dma1 ch6 (i2c1) / ch4 (i2c2) */
         i2c_config_t cfg;
         bool ready;
-    } i2c_bus_t;
+
+        /* transfer engine: slot pool + fifo of slot indices, driven by the i2c/dma isrs */
+        i2c_xfer_slot_t pool[I2C_XFER_POOL];
+        uint8_t fifo[I2C_XFER_POOL];
+        uint8_t fifo_head; /* free-running, masked on access */
+        uint8_t fifo_tail;
+        volatile uint8_t active; /* slot on the wire, 0xff when idle */
+
+        /* stuck-bus breaker, see i2c_service() */
+        volatile uint8_t health; /* i2c_health_t */
+        uint32_t deadline_ms;    /* the active transfer is hung after this tick */
+        uint32_t retry_ms;       /* next recovery attempt while down */
+        i2c_recovery_stats_t rec;
+    };
 
     /* api */
     i2c_status_t i2c_init(i2c_bus_t *bus, const i2c_config_t *cfg);
+
+    /* queue a transfer; never waits for the bus.
+     * - wlen only: write; rlen only: read; both: write, repeated start, read
+     * - buffers must stay valid until the transfer completes
+     * - cb (isr context, may be null) gets the result; with a callback the slot
+     *   is recycled right after it, without one the caller polls *out
+     * returns I2C_ST_BUSY when all I2C_XFER_POOL slots are in use and
+     * I2C_ST_BUSERR at once while the bus is not ok (i2c_service()).
+     */
+    i2c_status_t i2c_submit(i2c_bus_t *bus,
+                            uint8_t addr7,
+                            const uint8_t *wbuf,
+                            size_t wlen,
+                            uint8_t *rbuf,
+                            size_t rlen,
+                            i2c_done_cb_t cb,
+                            void *ctx,
+                            i2c_xfer_t *out);
+
+    /* result of a transfer submitted without callback: I2C_ST_BUSY while queued
+     * or on the wire, else its final status (the handle is released then)
+     */
+    i2c_status_t i2c_poll(i2c_bus_t *bus, i2c_xfer_t x);
+
+    /* blocking wrappers: submit, then poll until done or timeout_ms */
     i2c_status_t
     i2c_write(i2c_bus_t *bus, uint8_t addr7, const uint8_t *data, size_t len, uint32_t timeout_ms);
     i2c_status_t
@@ -54,8 +174,47 @@ extern "C"
                                 uint8_t *rbuf,
                                 size_t rlen,
                                 uint32_t timeout_ms);
+
+    /* polling hal probe; I2C_ST_BUSY while the engine has work queued */
     i2c_status_t i2c_is_ready(i2c_bus_t *bus, uint8_t addr7, uint8_t trials, uint32_t timeout_ms);
 
+    /* queued write (dma for 2+ bytes); same as i2c_submit() with a write only */
+    i2c_status_t i2c_write_dma(i2c_bus_t *bus,
+                               uint8_t addr7,
+                               const uint8_t *data,
+                               size_t len,
+                               i2c_done_cb_t cb,
+                               void *ctx);
+
+    /* true while transfers are queued or on the wire */
+    bool i2c_busy(const i2c_bus_t *bus);
+
+    /* stuck-bus watchdog; call from the main loop (thread context).
+ * a bus is stuck when sr2.busy stays set before a transfer starts, or when
+ * the transfer on the wire is past its deadline (I2C_XFER_MARGIN_MS). the
+ * breaker opens at once: queued and new transfers fail with I2C_ST_BUSERR
+ * instead of waiting out a timeout, and this call runs i2c_recover(). if the
+ * bus stays down, the next try comes I2C_RECOVER_RETRY_MS later.
+ */
+    void i2c_service(i2c_bus_t *bus);
+
+    /* stop the engine and fail all its transfers (I2C_ST_BUSERR), clock up to
+ * 9 scl pulses by gpio until sda is released, send a stop and set the
+ * peripheral up again from bus->cfg. I2C_ST_OK closes the breaker.
+ * ~100 us of busy-waiting: thread context only
+ */
+    i2c_status_t i2c_recover(i2c_bus_t *bus);
+
+    /* false while the breaker is open */
+    bool i2c_ok(const i2c_bus_t *bus);
+
+    i2c_recovery_stats_t i2c_get_recovery(const i2c_bus_t *bus);
+
+    /* interrupt entry points; call from the matching vectors in stm32f1xx_it.c */
+    void i2c_ev_irq(I2C_TypeDef *instance);
+    void i2c_er_irq(I2C_TypeDef *instance);
+    void i2c_dma_tx_irq(I2C_TypeDef *instance);
+
     /* optional: expose hal handle for advanced users */
     static inline I2C_HandleTypeDef *i2c_hal(i2c_bus_t *bus)
     {
@@ -1,85 +1,484 @@
 
 #include "ir.h"
+#include "ir_ring.h"
+#include "ir_tim.h"
+#include "ir_trace.h"
+#include "ir_filter.h"
+#include "ir_stats.h"
+#include "ir_spacing.h"
+#include "ir_coinc.h"
+#include "drivers/prof/prof.h"
+#include "drivers/gpio/gpio.h"
+#include "drivers/gpio/gpio_fast.h"
+#include "drivers/timebase/timebase.h"
 
-/* software dead-time to mitigate bounce/noise (ms) */
-#ifndef IR_DEBOUNCE_MS
-#define IR_DEBOUNCE_MS 3u
+/* channel table from IR_CHANNELS */
+typedef struct
+{
+    GPIO_TypeDef *port;
+    uint8_t line;
+} ir_chan_t;
+
+static const ir_chan_t s_chan[ir_count] = {
+#define IR_CH_ENTRY(id, port, line) {port, line},
+    IR_CHANNELS(IR_CH_ENTRY)
+#undef IR_CH_ENTRY
+};
+
+/* isr lookups built by ir_init(): exti line → channel, and per port in use the
+ * lines it carries, so one idr read per port covers every lane on it
+ */
+static uint8_t s_line_ch[16];
+static GPIO_TypeDef *s_port[5];
+static uint16_t s_port_lines[5];
+static uint32_t s_nports = 0;
+
+/* counters and last-event timestamps, one array per field. the raw counters
+ * only ever go up (ir_process); a reset moves the baseline instead, so an
+ * increment racing a reset is never lost, and readers report raw - base.
+ * corr is the count corrected by the spacing model: doubles left out, missed
+ * plantings added. merged counts breaks that were part of another channel's
+ * object (coincidence window), so objects = total - sum of merged.
+ */
+static struct
+{
+    volatile uint32_t cnt[ir_count];
+    volatile uint32_t corr[ir_count];
+    volatile uint32_t last_us[ir_count];
+    volatile uint32_t rejected[ir_count];
+    volatile uint32_t glitches[ir_count];
+    volatile uint32_t doubles[ir_count];
+    volatile uint32_t missed[ir_count];
+    volatile uint32_t merged[ir_count];
+    volatile uint32_t cnt_base[ir_count];
+    volatile uint32_t corr_base[ir_count];
+    volatile uint32_t rejected_base[ir_count];
+    volatile uint32_t glitches_base[ir_count];
+    volatile uint32_t doubles_base[ir_count];
+    volatile uint32_t missed_base[ir_count];
+    volatile uint32_t merged_base[ir_count];
+} s_ctr;
+
+/* seqlock over cnt/corr/merged and their bases: odd while an update is in progress. writers are
+ * ir_process() (thread) and the resets (any context); readers retry when it
+ * moved. on one core an odd value seen at entry means this context interrupted
+ * the writer, which cannot finish before we return: give up instead of spinning.
+ */
+static volatile uint32_t s_seq = 0;
+
+#ifndef IR_SNAPSHOT_TRIES
+#define IR_SNAPSHOT_TRIES 4u
 #endif
 
-/* counters and last-event timestamps per channel */
-static volatile uint32_t s_cnt[ir_count] = {0, 0, 0};
-static volatile uint32_t s_last_ms[ir_count] = {0, 0, 0};
+static bool write_begin(void)
+{
+    uint32_t seq = __atomic_load_n(&s_seq, __ATOMIC_RELAXED);
+    for (;;)
+    {
+        if (seq & 1u)
+            return false;
+        /* ldrex/strex on the m3; fails (and reloads seq) if an isr got in between */
+        if (__atomic_compare_exchange_n(&s_seq, &seq, seq + 1u, true, __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+            return true;
+    }
+}
 
-/* map gpio pin bit to ir_id */
-static inline ir_id_t pin_to_id(uint16_t pin)
+static void write_end(void)
 {
-    switch (pin)
+    (void) __atomic_fetch_add(&s_seq, 1u, __ATOMIC_RELEASE);
+}
+
+/* copy counts (raw - base) of every channel; false if no stable copy was possible */
+static bool read_counts(ir_snapshot_t *out)
+{
+    for (uint32_t tries = 0; tries < IR_SNAPSHOT_TRIES; tries++)
     {
-        case GPIO_PIN_0:
-            return ir0;
-        case GPIO_PIN_1:
-            return ir1;
-        case GPIO_PIN_2:
-            return ir2;
-        default:
-            return (ir_id_t) 255;
+        uint32_t seq = __atomic_load_n(&s_seq, __ATOMIC_ACQUIRE);
+        if (seq & 1u)
+            return false;
+
+        uint32_t total = 0;
+        uint32_t merged = 0;
+        for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+        {
+            out->count[ch] = s_ctr.cnt[ch] - s_ctr.cnt_base[ch];
+            out->corrected[ch] = s_ctr.corr[ch] - s_ctr.corr_base[ch];
+            total += out->count[ch];
+            merged += s_ctr.merged[ch] - s_ctr.merged_base[ch];
+        }
+        out->total = total;
+        out->objects = total - merged;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s_seq, __ATOMIC_RELAXED) == seq)
+        {
+            out->seq = seq >> 1;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* per-channel min pulse width + adaptive dead-time (IR_DEBOUNCE_US is the start value) */
+static ir_filter_t s_filt[ir_count];
+
+/* rate, gap histogram and min/max gap of counted breaks (owned by ir_process) */
+static ir_stats_t s_stats[ir_count];
+
+/* double/skip classifier (owned by ir_process) */
+static ir_spacing_t s_spacing[ir_count];
+
+/* channels whose coincident breaks are merged into one object */
+#ifndef IR_COINC_CHANNELS
+#define IR_COINC_CHANNELS ((1u << ir_count) - 1u)
+#endif
+
+static ir_coinc_t s_coinc;
+
+/* bit n = channel n has a break candidate waiting for its min width */
+static uint32_t s_cand = 0;
+
+/* raw edges from the exti isr, drained by ir_process() */
+static ir_ring_t s_ring;
+
+/* trace recorder: edges are encoded into a small batch, flushed per ir_process() */
+#ifndef IR_TRACE_BATCH
+#define IR_TRACE_BATCH 64u
+#endif
+
+static ir_trace_sink_t s_trace_sink = NULL;
+static void *s_trace_ctx = NULL;
+static ir_trace_enc_t s_trace_enc;
+static uint8_t s_trace_buf[IR_TRACE_BATCH + IR_TRACE_HDR_SIZE + IR_TRACE_REC_MAX];
+static uint32_t s_trace_len = 0;
+
+static void trace_flush(void)
+{
+    if (s_trace_len != 0u)
+    {
+        s_trace_sink(s_trace_buf, s_trace_len, s_trace_ctx);
+        s_trace_len = 0;
+    }
+}
+
+static void trace_record(const ir_event_t *e)
+{
+    s_trace_len += ir_trace_encode(&s_trace_enc, e, &s_trace_buf[s_trace_len]);
+    if (s_trace_len >= IR_TRACE_BATCH)
+    {
+        trace_flush();
+    }
+}
+
+/* build the isr lookups; false if two channels share an exti line */
+static bool map_channels(void)
+{
+    uint32_t used = 0;
+
+    s_nports = 0;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        const ir_chan_t *c = &s_chan[ch];
+        uint32_t bit = 1u << c->line;
+        if (c->line >= 16u || (used & bit))
+            return false;
+        used |= bit;
+        s_line_ch[c->line] = (uint8_t) ch;
+
+        uint32_t p = 0;
+        while (p < s_nports && s_port[p] != c->port)
+            p++;
+        if (p == s_nports)
+        {
+            s_port[p] = c->port;
+            s_port_lines[p] = 0;
+            s_nports++;
+        }
+        s_port_lines[p] |= (uint16_t) bit;
+    }
+    return true;
+}
+
+/* isr side for any set of ir lines that pended together: one idr read per port,
+ * one ring record, independent of how many lanes changed
+ */
+static void capture(uint16_t lines, void *ctx)
+{
+    PROF_SCOPE(gpio_isr);
+    (void) ctx;
+
+    uint32_t now = timebase_now_us();
+    uint32_t levels = 0;
+    for (uint32_t p = 0; p < s_nports; p++)
+    {
+        if (lines & s_port_lines[p])
+            levels |= s_port[p]->IDR & s_port_lines[p];
+    }
+
+    if (ir_ring_push(&s_ring, now, lines, (uint16_t) (levels & lines)))
+    {
+        ir_on_pending();
     }
 }
 
-/* configure pa0/pa1/pa2 as input with exti falling edge (beam break = low) */
+/* configure the channel pins as inputs with exti on both edges (beam break = low) */
 bool ir_init(void)
 {
-    __HAL_RCC_GPIOA_CLK_ENABLE();
-    __HAL_RCC_AFIO_CLK_ENABLE();
+    ir_ring_init(&s_ring);
+    s_cand = 0;
+    ir_coinc_init(&s_coinc);
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        ir_filter_init(&s_filt[ch]);
+        ir_stats_init(&s_stats[ch], timebase_now_us());
+        ir_spacing_init(&s_spacing[ch]);
+    }
+    if (!map_channels())
+    {
+        return false;
+    }
 
-    /* exti 0..2 are already connected to port a by default on f1 */
-    GPIO_InitTypeDef gi = {0};
-    gi.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2;
-    gi.Mode = GPIO_MODE_IT_FALLING; /* adjust to RISING or RISING_FALLING if needed */
-    gi.Pull = GPIO_PULLUP;          /* typical ir modules: open-collector low-active */
-    HAL_GPIO_Init(GPIOA, &gi);
+#if IR_BACKEND == IR_BACKEND_TIM2
+    return ir_tim_init(&s_ring);
+#else
+    /* every ir line goes to capture(), whichever vector serves it */
+    gpio_detach_irq_group(capture);
+    if (gpio_attach_irq_group((uint16_t) IR_LINE_MASK, capture, NULL) != gpio_ok)
+    {
+        return false;
+    }
 
-    /* irq priorities kept low to avoid starving other isrs */
-    HAL_NVIC_SetPriority(EXTI0_IRQn, 10, 0);
-    HAL_NVIC_EnableIRQ(EXTI0_IRQn);
-    HAL_NVIC_SetPriority(EXTI1_IRQn, 10, 0);
-    HAL_NVIC_EnableIRQ(EXTI1_IRQn);
-    HAL_NVIC_SetPriority(EXTI2_IRQn, 10, 0);
-    HAL_NVIC_EnableIRQ(EXTI2_IRQn);
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        gpio_pin_t pin = {s_chan[ch].port, (uint16_t) (1u << s_chan[ch].line)};
+
+        /* release edge feeds the min pulse width check; typical ir modules are
+         * open-collector low-active. irq priority kept low to avoid starving
+         * other isrs
+         */
+        if (gpio_setup_input_irq(&pin, GPIO_MODE_IT_RISING_FALLING, GPIO_PULLUP, 10) != gpio_ok)
+        {
+            return false;
+        }
+    }
 
     return true;
+#endif
+}
+
+GPIO_TypeDef *ir_get_port(ir_id_t id)
+{
+    if (id >= ir_count)
+        return NULL;
+    return s_chan[id].port;
 }
 
-/* this function is called from the gpio exti path:
- * hal: HAL_GPIO_EXTI_IRQHandler(pin) → HAL_GPIO_EXTI_Callback(pin)
- * your board layer should call gpio_on_interrupt(pin) there.
- * we implement gpio_on_interrupt() here to consume pa0..pa2.
+uint16_t ir_get_pin(ir_id_t id)
+{
+    if (id >= ir_count)
+        return 0;
+    return (uint16_t) (1u << s_chan[id].line);
+}
+
+/* legacy entry from the gpio exti path (hal callback of an unclaimed line, or a
+ * caller such as sprout_replay feeding pins directly); same as the group path
  */
 void gpio_on_interrupt(uint16_t gpio_pin)
 {
-    ir_id_t id = pin_to_id(gpio_pin);
-    if (id >= ir_count)
+    if (gpio_pin & IR_LINE_MASK)
     {
-        return;
+        capture((uint16_t) (gpio_pin & IR_LINE_MASK), NULL);
     }
+}
 
-    uint32_t now = HAL_GetTick();
-    uint32_t last = s_last_ms[id];
-    if ((now - last) < IR_DEBOUNCE_MS)
+#if GPIO_EXTI_FAST && IR_BACKEND == IR_BACKEND_EXTI
+/* fast exti path (gpio_fast.h) for ir lines 0..4: the vector already cleared pr
+ * and read the port's idr, so the level is a mask away
+ */
+static inline void fast_edge(uint32_t line, uint32_t idr)
+{
+    PROF_SCOPE(gpio_isr);
+
+    uint16_t bit = (uint16_t) (1u << line);
+    if (ir_ring_push(&s_ring, timebase_now_us(), bit, (uint16_t) (idr & bit)))
     {
-        /* ignore if inside dead-time */
-        return;
+        ir_on_pending();
     }
-    s_last_ms[id] = now;
+}
+
+#if IR_LINE_MASK & 0x01u
+void gpio_fast_line0(uint32_t idr)
+{
+    fast_edge(0, idr);
+}
+#endif
+#if IR_LINE_MASK & 0x02u
+void gpio_fast_line1(uint32_t idr)
+{
+    fast_edge(1, idr);
+}
+#endif
+#if IR_LINE_MASK & 0x04u
+void gpio_fast_line2(uint32_t idr)
+{
+    fast_edge(2, idr);
+}
+#endif
+#if IR_LINE_MASK & 0x08u
+void gpio_fast_line3(uint32_t idr)
+{
+    fast_edge(3, idr);
+}
+#endif
+#if IR_LINE_MASK & 0x10u
+void gpio_fast_line4(uint32_t idr)
+{
+    fast_edge(4, idr);
+}
+#endif
+#endif
 
-    /* sample pin level after edge */
-    bool level = (HAL_GPIO_ReadPin(GPIOA, gpio_pin) == GPIO_PIN_SET);
+/* a break passed the filter: count it and notify */
+static void accept(uint32_t ch)
+{
+    uint32_t t = s_filt[ch].t_fall;
+    uint32_t missed;
+    ir_spacing_class_t cls = ir_spacing_event(&s_spacing[ch], t, &missed);
+    bool object = ir_coinc_event(&s_coinc, IR_COINC_CHANNELS, ch, t);
 
-    /* increment counter on accepted event */
-    s_cnt[id]++;
+    /* ir_process() runs in thread context, where no update can be half done */
+    (void) write_begin();
+    s_ctr.last_us[ch] = t;
+    s_ctr.cnt[ch]++;
+    if (cls == IR_SPACING_DOUBLE)
+        s_ctr.doubles[ch]++;
+    else
+        s_ctr.corr[ch] += 1u + missed;
+    s_ctr.missed[ch] += missed;
+    if (!object)
+        s_ctr.merged[ch]++;
+    write_end();
+
+    ir_stats_event(&s_stats[ch], t);
 
     /* optional user hook */
-    ir_on_event(id, level);
+    ir_on_event((ir_id_t) ch, false);
+}
+
+/* one edge through the filter; keeps s_cand in step with the filter state */
+static void process_edge(const ir_event_t *e)
+{
+    if (s_trace_sink)
+    {
+        trace_record(e);
+    }
+
+    uint32_t ch = e->channel;
+    ir_filter_t *f = &s_filt[ch];
+
+    /* a candidate that stayed broken up to this edge is a real break */
+    if (ir_filter_poll(f, e->tick))
+    {
+        accept(ch);
+    }
+
+    switch (ir_filter_edge(f, e->tick, e->level))
+    {
+        case IR_EDGE_BOUNCE:
+            s_ctr.rejected[ch]++;
+            break;
+        case IR_EDGE_GLITCH:
+            s_ctr.glitches[ch]++;
+            break;
+        default:
+            break;
+    }
+
+    if (f->state == IR_FILT_CANDIDATE)
+        s_cand |= 1u << ch;
+    else
+        s_cand &= ~(1u << ch);
+}
+
+/* main loop side: filter, count and notify for every queued edge */
+uint32_t ir_process(void)
+{
+    PROF_SCOPE(ir_process);
+
+    uint32_t n = 0;
+    ir_edges_t r;
+    uint32_t now;
+
+    do
+    {
+        while (ir_ring_pop(&s_ring, &r))
+        {
+            /* expand the record lowest line first */
+            uint32_t lines = r.lines;
+            while (lines != 0u)
+            {
+                uint32_t line = (uint32_t) __builtin_ctz(lines);
+                lines &= lines - 1u;
+
+                ir_event_t e = {r.tick, s_line_ch[line], (uint8_t) ((r.levels >> line) & 1u)};
+                process_edge(&e);
+                n++;
+            }
+        }
+
+        /* sampled after draining, and again if an isr queued more meanwhile:
+         * the tim2 backend back-dates edges to their capture, so a release
+         * queued after this point could be older than it and must not let
+         * the poll below confirm a break it already ended
+         */
+        now = timebase_now_us();
+    } while (ir_ring_pending(&s_ring) != 0u);
+
+    /* breaks still held: count them once they are min_width old; only
+     * channels with an open candidate are visited
+     */
+    uint32_t cand = s_cand;
+    while (cand != 0u)
+    {
+        uint32_t ch = (uint32_t) __builtin_ctz(cand);
+        cand &= cand - 1u;
+
+        if (ir_filter_poll(&s_filt[ch], now))
+        {
+            s_cand &= ~(1u << ch);
+            accept(ch);
+        }
+    }
+
+    if (s_trace_sink)
+    {
+        trace_flush();
+    }
+
+    return n;
+}
+
+void ir_trace_attach(ir_trace_sink_t sink, void *ctx)
+{
+    if (s_trace_sink)
+    {
+        trace_flush();
+    }
+
+    s_trace_sink = sink;
+    s_trace_ctx = ctx;
+    s_trace_len = 0;
+    ir_trace_enc_init(&s_trace_enc, (uint8_t) ir_count);
+}
+
+uint32_t ir_get_overflows(void)
+{
+#if IR_BACKEND == IR_BACKEND_TIM2
+    return ir_ring_overflows(&s_ring) + ir_tim_overcaptures();
+#else
+    return ir_ring_overflows(&s_ring);
+#endif
 }
 
 /* counters api */
@@ -87,27 +486,251 @@ uint32_t ir_get_count(ir_id_t id)
 {
     if (id >= ir_count)
         return 0;
-    return s_cnt[id];
+    return s_ctr.cnt[id] - s_ctr.cnt_base[id];
+}
+
+uint32_t ir_get_rejected(ir_id_t id)
+{
+    if (id >= ir_count)
+        return 0;
+    return s_ctr.rejected[id] - s_ctr.rejected_base[id];
 }
 
-void ir_reset_count(ir_id_t id)
+uint32_t ir_get_glitches(ir_id_t id)
 {
     if (id >= ir_count)
-        return;
-    s_cnt[id] = 0;
+        return 0;
+    return s_ctr.glitches[id] - s_ctr.glitches_base[id];
+}
+
+uint32_t ir_get_corrected(ir_id_t id)
+{
+    if (id >= ir_count)
+        return 0;
+    return s_ctr.corr[id] - s_ctr.corr_base[id];
+}
+
+uint32_t ir_get_merged(ir_id_t id)
+{
+    if (id >= ir_count)
+        return 0;
+    return s_ctr.merged[id] - s_ctr.merged_base[id];
+}
+
+bool ir_get_filter(ir_id_t id, ir_filter_info_t *out)
+{
+    if (id >= ir_count || !out)
+        return false;
+
+    const ir_filter_t *f = &s_filt[id];
+    out->dead_us = f->dead_us;
+    out->min_width_us = f->min_width;
+    out->width_avg_us = f->width_avg;
+    out->gap_avg_us = f->gap_avg;
+    out->learned = f->samples >= IR_FILTER_WARMUP;
+    return true;
+}
+
+bool ir_get_stats(ir_id_t id, ir_stats_info_t *out)
+{
+    if (id >= ir_count || !out)
+        return false;
+
+    uint32_t now = timebase_now_us();
+    ir_stats_t *st = &s_stats[id];
+    ir_stats_roll(st, now);
+
+    out->rate_mhz = ir_stats_rate_mhz(st, now);
+    out->gap_avg_us = ir_stats_gap_avg_us(st);
+    out->window = st->done;
+    return true;
+}
+
+bool ir_get_spacing(ir_id_t id, ir_spacing_info_t *out)
+{
+    if (id >= ir_count || !out)
+        return false;
+
+    const ir_spacing_t *sp = &s_spacing[id];
+    out->expected_us = ir_spacing_expected_us(sp);
+    out->doubles = s_ctr.doubles[id] - s_ctr.doubles_base[id];
+    out->missed = s_ctr.missed[id] - s_ctr.missed_base[id];
+    out->last = sp->last;
+    return true;
+}
+
+uint32_t ir_get_last_us(ir_id_t id)
+{
+    if (id >= ir_count)
+        return 0;
+    return s_ctr.last_us[id];
+}
+
+/* move one channel's baselines up to its raw counters (inside write_begin) */
+static void rebase(uint32_t ch)
+{
+    s_ctr.cnt_base[ch] = s_ctr.cnt[ch];
+    s_ctr.corr_base[ch] = s_ctr.corr[ch];
+    s_ctr.rejected_base[ch] = s_ctr.rejected[ch];
+    s_ctr.glitches_base[ch] = s_ctr.glitches[ch];
+    s_ctr.doubles_base[ch] = s_ctr.doubles[ch];
+    s_ctr.missed_base[ch] = s_ctr.missed[ch];
+    s_ctr.merged_base[ch] = s_ctr.merged[ch];
+}
+
+bool ir_reset_count(ir_id_t id)
+{
+    if (id >= ir_count || !write_begin())
+        return false;
+    rebase(id);
+    write_end();
+    return true;
 }
 
 uint32_t ir_get_total(void)
 {
-    return s_cnt[0] + s_cnt[1] + s_cnt[2];
+    ir_snapshot_t snap;
+    if (ir_snapshot(&snap))
+        return snap.total;
+
+    /* an isr that interrupted an update: best effort, may be one break off */
+    uint32_t total = 0;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        total += s_ctr.cnt[ch] - s_ctr.cnt_base[ch];
+    }
+    return total;
+}
+
+uint32_t ir_get_objects(void)
+{
+    ir_snapshot_t snap;
+    if (ir_snapshot(&snap))
+        return snap.objects;
+
+    /* as ir_get_total() */
+    uint32_t objects = 0;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        objects += (s_ctr.cnt[ch] - s_ctr.cnt_base[ch]) - (s_ctr.merged[ch] - s_ctr.merged_base[ch]);
+    }
+    return objects;
+}
+
+bool ir_reset_all(void)
+{
+    return ir_snapshot_reset(NULL);
+}
+
+bool ir_snapshot(ir_snapshot_t *out)
+{
+    if (!out)
+        return false;
+    return read_counts(out);
+}
+
+bool ir_snapshot_reset(ir_snapshot_t *out)
+{
+    if (!write_begin())
+        return false;
+
+    /* nothing can count between the copy and the rebase: every break is either
+     * in this snapshot or in the next one
+     */
+    uint32_t total = 0;
+    uint32_t merged = 0;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        uint32_t n = s_ctr.cnt[ch] - s_ctr.cnt_base[ch];
+        if (out)
+        {
+            out->count[ch] = n;
+            out->corrected[ch] = s_ctr.corr[ch] - s_ctr.corr_base[ch];
+        }
+        total += n;
+        merged += s_ctr.merged[ch] - s_ctr.merged_base[ch];
+        rebase(ch);
+    }
+    write_end();
+
+    if (out)
+    {
+        out->total = total;
+        out->objects = total - merged;
+        out->seq = __atomic_load_n(&s_seq, __ATOMIC_RELAXED) >> 1;
+    }
+    return true;
+}
+
+bool ir_restore(const ir_snapshot_t *in)
+{
+    if (!in || !write_begin())
+        return false;
+
+    /* objects = total - merged: the merged breaks go to the first channels,
+     * at most their own count each
+     */
+    uint32_t total = 0;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        total += in->count[ch];
+    }
+    uint32_t merged = (in->objects < total) ? total - in->objects : 0u;
+
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        uint32_t m = (merged < in->count[ch]) ? merged : in->count[ch];
+        merged -= m;
+
+        rebase(ch);
+        s_ctr.cnt_base[ch] -= in->count[ch];
+        s_ctr.corr_base[ch] -= in->corrected[ch];
+        s_ctr.merged_base[ch] -= m;
+    }
+    write_end();
+    return true;
+}
+
+uint32_t ir_quiet_us(void)
+{
+    if (ir_ring_pending(&s_ring) != 0u)
+        return 0;
+
+    uint32_t now = timebase_now_us();
+    uint32_t quiet = UINT32_MAX;
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        const ir_filter_t *f = &s_filt[ch];
+        if (f->state != IR_FILT_IDLE)
+            return 0;
+        if (f->samples == 0u)
+            continue;
+
+        uint32_t since = now - f->last_fall;
+        uint32_t e = ir_spacing_expected_us(&s_spacing[ch]);
+        uint32_t left;
+        if (e == 0u || since / e > IR_SPACING_MAX_SKIP)
+        {
+            /* learning or stopped: no prediction, only idle time */
+            left = (since >= IR_QUIET_IDLE_US) ? UINT32_MAX : 0u;
+        }
+        else
+        {
+            uint32_t early = e - (e >> 2);
+            left = (since < early) ? early - since : 0u;
+        }
+        if (left < quiet)
+            quiet = left;
+    }
+    return quiet;
 }
 
-void ir_reset_all(void)
+/* default weak hooks; user can override elsewhere */
+void __attribute__((weak)) ir_on_pending(void)
 {
-    s_cnt[0] = s_cnt[1] = s_cnt[2] = 0;
+    /* no-op: the main loop polls ir_process() */
 }
 
-/* default weak hook; user can override elsewhere */
 void __attribute__((weak)) ir_on_event(ir_id_t id, bool level)
 {
     (void) id;
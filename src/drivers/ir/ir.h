@@ -4,28 +4,185 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "stm32f1xx_hal.h"
+#include "ir_stats.h"
+#include "ir_spacing.h"
+
+/* counting backends, selected at build time with -DIR_BACKEND=...
+ * - exti: pin change interrupts, edge timestamped in the isr (default)
+ * - tim2: tim2_ch1..ch3 input capture with hardware filter and timestamp
+ */
+#define IR_BACKEND_EXTI 0
+#define IR_BACKEND_TIM2 1
+
+#ifndef IR_BACKEND
+#define IR_BACKEND IR_BACKEND_EXTI
+#endif
+
+/* channel table: X(id, port, line) in id order, at most 16 channels.
+ * one channel per exti line (a line is shared by all ports).
+ * default pa0→ir0, pa1→ir1, pa2→ir2; a board with more rows passes its own:
+ *   -D'IR_CHANNELS(X)=X(ir0, GPIOA, 0) X(ir1, GPIOA, 1) ... X(ir9, GPIOB, 10)'
+ */
+#ifndef IR_CHANNELS
+#define IR_CHANNELS(X) \
+    X(ir0, GPIOA, 0)   \
+    X(ir1, GPIOA, 1)   \
+    X(ir2, GPIOA, 2)
+#endif
+
+/* channel count and exti lines in use; both work in #if */
+#define IR_CH_ONE(id, port, line) +1
+#define IR_CH_LINE(id, port, line) | (1u << (line))
+#define IR_NUM_CHANNELS (0 IR_CHANNELS(IR_CH_ONE))
+#define IR_LINE_MASK (0u IR_CHANNELS(IR_CH_LINE))
+
+#if IR_NUM_CHANNELS > 16
+#error "at most 16 ir channels (one per exti line)"
+#endif
 
-/* fixed mapping: pa0→ir0, pa1→ir1, pa2→ir2 */
 typedef enum
 {
-    ir0 = 0,
-    ir1 = 1,
-    ir2 = 2,
-    ir_count = 3
+#define IR_CH_ID(id, port, line) id,
+    IR_CHANNELS(IR_CH_ID)
+#undef IR_CH_ID
+    ir_count
 } ir_id_t;
 
-/* initialize pa0/pa1/pa2 as input with exti (falling edge by default) */
+/* initialize the table's pins as inputs with exti (or tim2 capture) on both edges;
+ * false if two channels share an exti line
+ */
 bool ir_init(void);
 
+/* port and pin (GPIO_PIN_x) of a channel; null / 0 for an unknown id */
+GPIO_TypeDef *ir_get_port(ir_id_t id);
+uint16_t ir_get_pin(ir_id_t id);
+
+/* drain edges queued by the isr: filter, count and call ir_on_event() for each
+ * accepted break. a break is accepted once it has lasted the channel's minimum
+ * pulse width, so call this from the main loop at least every millisecond or
+ * so (each wake-up is fine); returns edges consumed.
+ */
+uint32_t ir_process(void);
+
+/* edges lost: isr ring full (not drained fast enough) or, on the tim2
+ * backend, a capture overwritten before the isr read it
+ */
+uint32_t ir_get_overflows(void);
+
+/* edges dropped by the debounce dead-time (bounce/noise) since the last reset */
+uint32_t ir_get_rejected(ir_id_t id);
+
+/* breaks shorter than the minimum pulse width since the last reset */
+uint32_t ir_get_glitches(ir_id_t id);
+
+/* current per-channel filter parameters (see ir_filter.h) */
+typedef struct
+{
+    uint32_t dead_us;      /* dead-time after a counted break */
+    uint32_t min_width_us; /* shortest break that counts */
+    uint32_t width_avg_us; /* mean width of counted breaks */
+    uint32_t gap_avg_us;   /* mean spacing of counted breaks */
+    bool learned;          /* false while the compile-time defaults still apply */
+} ir_filter_info_t;
+
+bool ir_get_filter(ir_id_t id, ir_filter_info_t *out);
+
+/* live rate and gap statistics of counted breaks (see ir_stats.h); main loop
+ * context, like ir_process()
+ */
+typedef struct
+{
+    uint32_t rate_mhz;        /* breaks per 1000 s, decays while nothing is counted */
+    uint32_t gap_avg_us;      /* mean spacing (ewma) */
+    ir_stats_window_t window; /* gap histogram and min/max of the last complete window */
+} ir_stats_info_t;
+
+bool ir_get_stats(ir_id_t id, ir_stats_info_t *out);
+
+/* spacing model of a channel (see ir_spacing.h); counters since the last reset */
+typedef struct
+{
+    uint32_t expected_us; /* learned spacing, 0 while learning */
+    uint32_t doubles;     /* breaks left out as second triggers */
+    uint32_t missed;      /* plantings added for skips */
+    uint8_t last;         /* ir_spacing_class_t of the last counted break */
+} ir_spacing_info_t;
+
+bool ir_get_spacing(ir_id_t id, ir_spacing_info_t *out);
+
+/* raw edge recorder: ir_process() hands every queued edge, before debounce,
+ * to the sink as ir_trace bytes (header first). runs in main loop context.
+ * pass null to stop; attaching again starts a new trace.
+ */
+typedef void (*ir_trace_sink_t)(const uint8_t *data, uint32_t len, void *ctx);
+void ir_trace_attach(ir_trace_sink_t sink, void *ctx);
+
 /* counters api */
 uint32_t ir_get_count(ir_id_t id);
-void ir_reset_count(ir_id_t id);
+/* count corrected by the spacing model: count - doubles + missed */
+uint32_t ir_get_corrected(ir_id_t id);
+/* breaks that fell in the coincidence window (ir_coinc.h) of another
+ * channel's break, i.e. the same object seen twice
+ */
+uint32_t ir_get_merged(ir_id_t id);
+/* timestamp (timebase_now_us) of the last accepted event on a channel */
+uint32_t ir_get_last_us(ir_id_t id);
 uint32_t ir_get_total(void);
-void ir_reset_all(void);
+/* objects: total with coincident breaks on several channels counted once */
+uint32_t ir_get_objects(void);
+
+/* all channel counts read as one consistent set (seqlock, no irq masking) */
+typedef struct
+{
+    uint32_t seq;                 /* changes with every counted break and every reset */
+    uint32_t total;               /* sum of count[] */
+    uint32_t objects;             /* total with coincident breaks counted once */
+    uint32_t count[ir_count];     /* per channel since the last reset */
+    uint32_t corrected[ir_count]; /* same, corrected for doubles and skips */
+} ir_snapshot_t;
+
+/* consistent copy; false only when called from an isr that interrupted a
+ * counter update (retry later from thread context)
+ */
+bool ir_snapshot(ir_snapshot_t *out);
+
+/* snapshot and restart every channel from zero in one step: a break lands
+ * either in this snapshot or in the next one, never in neither.
+ * out may be null (plain reset). false as for ir_snapshot().
+ */
+bool ir_snapshot_reset(ir_snapshot_t *out);
+
+/* zero one channel / all channels (every counter); false as above */
+bool ir_reset_count(ir_id_t id);
+bool ir_reset_all(void);
+
+/* make the counters read as a saved snapshot (count, corrected, objects),
+ * e.g. at boot; breaks counted since go on top. the other counters restart
+ * from zero. false as for ir_snapshot()
+ */
+bool ir_restore(const ir_snapshot_t *in);
+
+/* lanes with no learned spacing count as quiet this long after their last break */
+#ifndef IR_QUIET_IDLE_US
+#define IR_QUIET_IDLE_US 500000u
+#endif
+
+/* how long no edge is expected on any channel (us, UINT32_MAX = no activity),
+ * for work that stalls the core, such as a flash erase: 0 while a beam is
+ * broken or edges are queued; a lane with a learned spacing expects its next
+ * break 3/4 of a spacing after the last one, and is quiet again once it has
+ * missed IR_SPACING_MAX_SKIP of them (stopped). main loop context
+ */
+uint32_t ir_quiet_us(void);
+
+/* optional user hook: called from the capture isr after edges were queued,
+ * e.g. to wake the task that calls ir_process(). keep it short.
+ */
+void ir_on_pending(void);
 
-/* optional user hook: called on each accepted event after debounce
- * level is the sampled logical level after the interrupt edge
+/* optional user hook: called from ir_process() on each accepted break
+ * level is the logical pin level of the break (false: beam broken, active low)
  */
-__attribute__((weak)) void ir_on_event(ir_id_t id, bool level);
+void ir_on_event(ir_id_t id, bool level);
 
 #endif /* IR_H */
@@ -0,0 +1,27 @@
+#include "ir_coinc.h"
+
+void ir_coinc_init(ir_coinc_t *c)
+{
+    c->t0 = 0;
+    c->mask = 0;
+}
+
+bool ir_coinc_event(ir_coinc_t *c, uint32_t members, uint32_t ch, uint32_t t_us)
+{
+    uint32_t bit = 1u << ch;
+    if (IR_COINC_US == 0u || !(members & bit))
+        return true;
+
+    /* either side of the first break, wrap-safe */
+    bool inside = (t_us - c->t0) <= IR_COINC_US || (c->t0 - t_us) <= IR_COINC_US;
+
+    if (c->mask != 0u && inside && !(c->mask & bit))
+    {
+        c->mask |= bit;
+        return false;
+    }
+
+    c->t0 = t_us;
+    c->mask = bit;
+    return true;
+}
@@ -0,0 +1,38 @@
+#ifndef IR_COINC_H
+#define IR_COINC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* cross-channel coincidence: counted breaks on different channels that start
+ * within IR_COINC_US of each other are one object (a leaf across two beams)
+ *
+ * a group opens with its first break and takes at most one break per channel;
+ * the window is measured from that first break, so a chain of staggered
+ * breaks does not merge into one long object. breaks reach the engine in
+ * acceptance order, which can differ from time order by a pulse width, so
+ * breaks shortly before the group's first one join as well.
+ * only channels in the mask take part; others are always objects of their own.
+ * o(1) per break.
+ */
+
+/* window (us); 0 turns merging off */
+#ifndef IR_COINC_US
+#define IR_COINC_US 500u
+#endif
+
+typedef struct
+{
+    uint32_t t0;   /* first break of the open group */
+    uint32_t mask; /* channels in the open group, 0 = none open */
+} ir_coinc_t;
+
+void ir_coinc_init(ir_coinc_t *c);
+
+/* counted break on channel ch at t_us; members = bit mask of the channels
+ * that take part. true = a new object, false = it belongs to the object of
+ * an earlier break on another channel
+ */
+bool ir_coinc_event(ir_coinc_t *c, uint32_t members, uint32_t ch, uint32_t t_us);
+
+#endif /* IR_COINC_H */
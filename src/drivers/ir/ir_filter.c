@@ -0,0 +1,162 @@
+#include "ir_filter.h"
+
+/* ewma steps as shifts: mean 1/8, peak trackers rise 1/4 and decay 1/32 */
+#define EWMA_SHIFT 3u
+#define PEAK_UP_SHIFT 2u
+#define PEAK_DOWN_SHIFT 5u
+
+/* widths and gaps are learned up to this; longer is a stop, not a pulse */
+#define LEARN_CAP_US (1u << 30u)
+/* once learned, a gap counts at most this many mean gaps (a pause in the
+ * line), so one stop cannot lift the dead-time cap in retune()
+ */
+#define GAP_PAUSE_RATIO 4u
+
+static inline void ewma(uint32_t *avg, uint32_t x)
+{
+    if (x > *avg)
+        *avg += (x - *avg) >> EWMA_SHIFT;
+    else
+        *avg -= (*avg - x) >> EWMA_SHIFT;
+}
+
+static inline uint32_t min_u32(uint32_t a, uint32_t b)
+{
+    return (a < b) ? a : b;
+}
+
+static inline void peak(uint32_t *hi, uint32_t x)
+{
+    if (x > *hi)
+        *hi += (x - *hi) >> PEAK_UP_SHIFT;
+    else
+        *hi -= (*hi - x) >> PEAK_DOWN_SHIFT;
+}
+
+static inline uint32_t clamp(uint32_t v, uint32_t lo, uint32_t hi)
+{
+    if (hi < lo)
+        hi = lo;
+    return (v < lo) ? lo : (v > hi) ? hi : v;
+}
+
+/* longest gap the mean takes: GAP_PAUSE_RATIO mean gaps, so a lane that
+ * slows down still gets there step by step
+ */
+static uint32_t pause_cap(const ir_filter_t *f)
+{
+    uint32_t avg = (f->gap_avg > IR_DEAD_MIN_US) ? f->gap_avg : IR_DEAD_MIN_US;
+    return (avg < LEARN_CAP_US / GAP_PAUSE_RATIO) ? avg * GAP_PAUSE_RATIO : LEARN_CAP_US;
+}
+
+/* re-derive dead-time and min width from the learned statistics */
+static void retune(ir_filter_t *f)
+{
+#if IR_FILTER_ADAPT
+    if (f->samples < IR_FILTER_WARMUP)
+        return;
+
+    uint32_t dead_cap = (f->gap_avg >> 1) < IR_DEAD_MAX_US ? (f->gap_avg >> 1) : IR_DEAD_MAX_US;
+    f->dead_us = clamp((f->settle_hi << 1) + IR_DEAD_MARGIN_US, IR_DEAD_MIN_US, dead_cap);
+    f->min_width = clamp(f->glitch_hi << 1, IR_MIN_PULSE_US, f->width_avg >> 1);
+#else
+    (void) f;
+#endif
+}
+
+/* a bounce or glitch at tick: remember how far after the last counted break it was.
+ * only look twice the current dead-time ahead, so noise at the start of the
+ * next pulse is not taken for the tail of this one; the window grows with dead_us.
+ */
+static void note_spread(ir_filter_t *f, uint32_t tick)
+{
+    uint32_t off = tick - f->last_fall;
+    if (f->samples != 0u && off < (f->dead_us << 1) && off < IR_DEAD_MAX_US && off > f->spread)
+        f->spread = off;
+}
+
+void ir_filter_init(ir_filter_t *f)
+{
+    f->t_fall = 0;
+    f->last_fall = 0;
+    f->spread = 0;
+    f->dead_us = IR_DEBOUNCE_US;
+    f->min_width = IR_MIN_PULSE_US;
+    f->width_avg = 0;
+    f->gap_avg = 0;
+    f->glitch_hi = 0;
+    f->settle_hi = 0;
+    f->samples = 0;
+    f->state = IR_FILT_IDLE;
+}
+
+bool ir_filter_poll(ir_filter_t *f, uint32_t now_us)
+{
+    if (f->state != IR_FILT_CANDIDATE || (now_us - f->t_fall) < f->min_width)
+        return false;
+
+    /* close the previous pulse's bounce window and learn from it */
+    if (f->samples != 0u)
+    {
+        uint32_t gap = min_u32(f->t_fall - f->last_fall, LEARN_CAP_US);
+        if (f->samples == 1u)
+            f->gap_avg = gap;
+        else
+            ewma(&f->gap_avg, min_u32(gap, pause_cap(f)));
+        peak(&f->settle_hi, f->spread);
+    }
+    if (f->samples != UINT32_MAX)
+        f->samples++;
+
+    f->last_fall = f->t_fall;
+    f->spread = 0;
+    f->state = IR_FILT_COUNTED;
+    retune(f);
+    return true;
+}
+
+ir_edge_t ir_filter_edge(ir_filter_t *f, uint32_t tick, uint8_t level)
+{
+    if (level == 0u)
+    {
+        if (f->state == IR_FILT_CANDIDATE)
+            return IR_EDGE_IGNORED;
+
+        /* broken again without a release in between: the release was lost */
+        f->state = IR_FILT_IDLE;
+
+        if (f->samples != 0u && (tick - f->last_fall) < f->dead_us)
+        {
+            note_spread(f, tick);
+            return IR_EDGE_BOUNCE;
+        }
+
+        f->t_fall = tick;
+        f->state = IR_FILT_CANDIDATE;
+        return IR_EDGE_START;
+    }
+
+    if (f->state == IR_FILT_CANDIDATE)
+    {
+        /* ir_filter_poll() at this tick already failed, so it was too short */
+        peak(&f->glitch_hi, tick - f->t_fall);
+        note_spread(f, f->t_fall);
+        f->state = IR_FILT_IDLE;
+        retune(f);
+        return IR_EDGE_GLITCH;
+    }
+
+    if (f->state == IR_FILT_COUNTED)
+    {
+        uint32_t width = min_u32(tick - f->t_fall, LEARN_CAP_US);
+        if (f->samples == 1u)
+            f->width_avg = width;
+        else
+            ewma(&f->width_avg, width);
+        f->state = IR_FILT_IDLE;
+        retune(f);
+        return IR_EDGE_RELEASE;
+    }
+
+    return IR_EDGE_IGNORED;
+}
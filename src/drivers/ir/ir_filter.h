@@ -0,0 +1,102 @@
+#ifndef IR_FILTER_H
+#define IR_FILTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* per-channel edge filter: minimum pulse width on both edges + adaptive dead-time
+ *
+ * a beam break (falling edge) only becomes a candidate. it is counted once the
+ * beam has stayed broken for min_width_us; a release before that is a glitch.
+ * a new break within dead_us of the last counted one is a bounce.
+ *
+ * the filter learns per channel with shift-only ewmas (o(1), no divides):
+ * - width_avg / gap_avg: mean break width and spacing of counted pulses
+ * - glitch_hi: peak of rejected glitch widths  → min_width = 2 x glitch_hi
+ * - settle_hi: peak of how long after a counted break bounces/glitches still
+ *   show up → dead = 2 x settle_hi + IR_DEAD_MARGIN_US
+ * both are clamped so they never exceed half of a real pulse width/spacing.
+ * a gap enters gap_avg as at most 4 mean gaps, so a pause in the line (even
+ * one past the 2^31 us timestamp range) does not lift the dead-time cap.
+ * until IR_FILTER_WARMUP pulses were seen the compile-time defaults apply.
+ */
+
+/* starting (and, with IR_FILTER_ADAPT=0, fixed) dead-time; see ir.c */
+#ifndef IR_DEBOUNCE_US
+#ifdef IR_DEBOUNCE_MS
+#define IR_DEBOUNCE_US ((IR_DEBOUNCE_MS) * 1000u)
+#else
+#define IR_DEBOUNCE_US 3000u
+#endif
+#endif
+
+/* shortest break that counts (us); also the floor of the adaptive value */
+#ifndef IR_MIN_PULSE_US
+#define IR_MIN_PULSE_US 200u
+#endif
+
+/* 1: adapt dead-time and min width per channel, 0: fixed defaults */
+#ifndef IR_FILTER_ADAPT
+#define IR_FILTER_ADAPT 1
+#endif
+
+/* bounds of the adaptive dead-time (us) */
+#ifndef IR_DEAD_MIN_US
+#define IR_DEAD_MIN_US 500u
+#endif
+#ifndef IR_DEAD_MAX_US
+#define IR_DEAD_MAX_US 20000u
+#endif
+#ifndef IR_DEAD_MARGIN_US
+#define IR_DEAD_MARGIN_US 250u
+#endif
+
+/* counted pulses before the learned values replace the defaults */
+#ifndef IR_FILTER_WARMUP
+#define IR_FILTER_WARMUP 8u
+#endif
+
+typedef enum
+{
+    IR_FILT_IDLE = 0,  /* beam clear */
+    IR_FILT_CANDIDATE, /* broken, shorter than min_width so far */
+    IR_FILT_COUNTED    /* broken and counted, waiting for the release */
+} ir_filt_state_t;
+
+/* what an edge turned out to be */
+typedef enum
+{
+    IR_EDGE_IGNORED = 0, /* same level again (missed edge) */
+    IR_EDGE_START,       /* break candidate opened */
+    IR_EDGE_BOUNCE,      /* re-break inside the dead-time */
+    IR_EDGE_GLITCH,      /* released before min_width */
+    IR_EDGE_RELEASE      /* end of a counted break */
+} ir_edge_t;
+
+typedef struct
+{
+    uint32_t t_fall;     /* start of the current break */
+    uint32_t last_fall;  /* start of the last counted break */
+    uint32_t spread;     /* latest bounce/glitch offset after last_fall */
+    uint32_t dead_us;    /* current dead-time */
+    uint32_t min_width;  /* current minimum break width */
+    uint32_t width_avg;  /* ewma 1/8 of counted break widths */
+    uint32_t gap_avg;    /* ewma 1/8 of spacing between counted breaks */
+    uint32_t glitch_hi;  /* peak tracker of glitch widths */
+    uint32_t settle_hi;  /* peak tracker of the bounce spread */
+    uint32_t samples;    /* counted pulses seen (saturating) */
+    uint8_t state;       /* ir_filt_state_t */
+} ir_filter_t;
+
+void ir_filter_init(ir_filter_t *f);
+
+/* confirm a candidate that has stayed broken until now_us; true = count it
+ * (its timestamp is f->t_fall). call before ir_filter_edge() with the edge
+ * time, and from the main loop with the current time.
+ */
+bool ir_filter_poll(ir_filter_t *f, uint32_t now_us);
+
+/* classify one raw edge (level = pin level after the edge, 0 = broken) */
+ir_edge_t ir_filter_edge(ir_filter_t *f, uint32_t tick, uint8_t level);
+
+#endif /* IR_FILTER_H */
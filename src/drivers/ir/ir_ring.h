@@ -0,0 +1,108 @@
+#ifndef IR_RING_H
+#define IR_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* lock-free isr → main loop event ring for raw ir edges
+ * - one record holds every edge captured together: a bitmask of exti lines
+ *   plus the levels from the same idr snapshot, so simultaneous edges on many
+ *   lanes cost one push
+ * - single producer (exti isr) writes head, single consumer (main loop) writes tail
+ * - indices run free and are masked on access, so full/empty never alias
+ * - on overflow the new record is dropped and counted; older records are kept
+ */
+
+/* capacity in records; must be a power of two */
+#ifndef IR_RING_SIZE
+#define IR_RING_SIZE 64u
+#endif
+
+#if (IR_RING_SIZE & (IR_RING_SIZE - 1u)) != 0u
+#error "IR_RING_SIZE must be a power of two"
+#endif
+
+/* one raw edge on one channel (no debounce applied yet); ir_process() and the
+ * trace format work on these
+ */
+typedef struct
+{
+    uint32_t tick;   /* timestamp of the edge (timebase_now_us) */
+    uint8_t channel; /* ir_id_t */
+    uint8_t level;   /* sampled pin level after the edge */
+} ir_event_t;
+
+/* edges captured in one isr pass */
+typedef struct
+{
+    uint32_t tick;   /* timestamp of the edges (timebase_now_us) */
+    uint16_t lines;  /* bit n = exti line n changed */
+    uint16_t levels; /* bit n = level of line n after the edge */
+} ir_edges_t;
+
+typedef struct
+{
+    ir_edges_t buf[IR_RING_SIZE];
+    uint32_t head;      /* written by producer only */
+    uint32_t tail;      /* written by consumer only */
+    uint32_t overflows; /* written by producer only */
+} ir_ring_t;
+
+static inline void ir_ring_init(ir_ring_t *r)
+{
+    r->head = 0;
+    r->tail = 0;
+    r->overflows = 0;
+}
+
+/* producer side (isr): returns false and counts an overflow when full */
+static inline bool ir_ring_push(ir_ring_t *r, uint32_t tick, uint16_t lines, uint16_t levels)
+{
+    uint32_t h = r->head;
+    uint32_t t = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if ((h - t) >= IR_RING_SIZE)
+    {
+        r->overflows++;
+        return false;
+    }
+
+    ir_edges_t *e = &r->buf[h & (IR_RING_SIZE - 1u)];
+    e->tick = tick;
+    e->lines = lines;
+    e->levels = levels;
+
+    /* publish the record only after its payload is written */
+    __atomic_store_n(&r->head, h + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* consumer side (main loop): returns false when empty */
+static inline bool ir_ring_pop(ir_ring_t *r, ir_edges_t *out)
+{
+    uint32_t t = r->tail;
+    uint32_t h = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    if (h == t)
+    {
+        return false;
+    }
+
+    *out = r->buf[t & (IR_RING_SIZE - 1u)];
+
+    /* hand the slot back only after the copy is done */
+    __atomic_store_n(&r->tail, t + 1u, __ATOMIC_RELEASE);
+    return true;
+}
+
+/* number of records waiting; safe from either side */
+static inline uint32_t ir_ring_pending(const ir_ring_t *r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t ir_ring_overflows(const ir_ring_t *r)
+{
+    return __atomic_load_n(&r->overflows, __ATOMIC_RELAXED);
+}
+
+#endif /* IR_RING_H */
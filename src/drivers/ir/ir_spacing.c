@@ -0,0 +1,142 @@
+#include "ir_spacing.h"
+
+#define Q 4u
+#define EWMA_SHIFT 3u
+
+/* largest gap fed to the model, so gap << Q fits in 31 bits */
+#define GAP_CAP_US (1u << (30u - Q))
+
+/* e x frac (8 fraction bits) */
+static inline uint32_t scale(uint32_t e, uint32_t q8)
+{
+    return (uint32_t) (((uint64_t) e * q8) >> 8);
+}
+
+static inline uint32_t median3(uint32_t a, uint32_t b, uint32_t c)
+{
+    if (a > b)
+    {
+        uint32_t t = a;
+        a = b;
+        b = t;
+    }
+    /* a <= b */
+    return (c < a) ? a : (c > b) ? b : c;
+}
+
+static void learn_again(ir_spacing_t *s)
+{
+    s->exp_q = 0;
+    s->gaps = 0;
+    s->streak = 0;
+}
+
+static void track(ir_spacing_t *s, uint32_t gap)
+{
+    uint32_t x = ((gap < GAP_CAP_US) ? gap : GAP_CAP_US) << Q;
+    s->exp_q = (uint32_t) ((int32_t) s->exp_q + (((int32_t) x - (int32_t) s->exp_q) >> EWMA_SHIFT));
+}
+
+void ir_spacing_init(ir_spacing_t *s)
+{
+    s->last_us = 0;
+    s->seed[0] = 0;
+    s->seed[1] = 0;
+    s->started = 0;
+    s->last = IR_SPACING_NORMAL;
+    learn_again(s);
+}
+
+uint32_t ir_spacing_expected_us(const ir_spacing_t *s)
+{
+    return s->exp_q >> Q;
+}
+
+/* learning: every break is normal until the third gap seeds the model */
+static ir_spacing_class_t learn(ir_spacing_t *s, uint32_t gap)
+{
+    if (s->gaps < 2u)
+    {
+        s->seed[s->gaps++] = gap;
+        return IR_SPACING_NORMAL;
+    }
+
+    uint32_t m = median3(s->seed[0], s->seed[1], gap);
+    s->exp_q = ((m < GAP_CAP_US) ? m : GAP_CAP_US) << Q;
+    if (s->exp_q == 0u)
+        s->exp_q = 1u; /* two breaks at the same tick: keep "learned" */
+    return IR_SPACING_NORMAL;
+}
+
+ir_spacing_class_t ir_spacing_event(ir_spacing_t *s, uint32_t t_us, uint32_t *missed)
+{
+    *missed = 0;
+
+    if (!s->started)
+    {
+        s->started = 1;
+        s->last_us = t_us;
+        s->last = IR_SPACING_NORMAL;
+        return IR_SPACING_NORMAL;
+    }
+
+    uint32_t gap = t_us - s->last_us;
+    ir_spacing_class_t cls = IR_SPACING_NORMAL;
+
+    if (s->exp_q == 0u)
+    {
+        cls = learn(s, gap);
+    }
+    else
+    {
+        uint32_t e = s->exp_q >> Q;
+
+        if (gap < scale(e, IR_SPACING_DOUBLE_Q8))
+        {
+            cls = IR_SPACING_DOUBLE;
+        }
+        else if (gap > scale(e, IR_SPACING_SKIP_Q8))
+        {
+            /* gap rounded to whole spacings: n missed when it is past (n + 1.5) x e */
+            uint32_t n = 1;
+            uint32_t edge = e + e + (e >> 1);
+            while (n <= IR_SPACING_MAX_SKIP && gap >= edge)
+            {
+                n++;
+                edge += e;
+            }
+
+            if (n > IR_SPACING_MAX_SKIP)
+            {
+                /* lane stopped: start over from this break */
+                learn_again(s);
+            }
+            else
+            {
+                cls = IR_SPACING_SKIP_AFTER;
+                *missed = n;
+                /* the last interval alone tracks the speed */
+                track(s, gap - n * e);
+            }
+        }
+        else
+        {
+            track(s, gap);
+        }
+
+        if (cls == IR_SPACING_NORMAL)
+        {
+            s->streak = 0;
+        }
+        else if (++s->streak >= IR_SPACING_RELEARN)
+        {
+            learn_again(s);
+        }
+    }
+
+    /* a double is the same seedling again: keep measuring from the real one */
+    if (cls != IR_SPACING_DOUBLE)
+        s->last_us = t_us;
+    s->last = (uint8_t) cls;
+    return cls;
+}
@@ -0,0 +1,71 @@
+#ifndef IR_SPACING_H
+#define IR_SPACING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* per-lane spacing model: flags counted breaks as doubles or as coming after
+ * missed plantings
+ *
+ * the expected spacing is learned online: the median of the first 3 gaps seeds
+ * it (one double or skip among them does not matter), then a 1/8 ewma follows
+ * slow speed changes. each counted break is then
+ * - double: closer than IR_SPACING_DOUBLE_Q8 x expected to the last real one,
+ *   i.e. the same seedling seen twice; it does not count and the next gap is
+ *   still measured from the real one
+ * - skip-after: more than IR_SPACING_SKIP_Q8 x expected after the last one;
+ *   the gap rounded to whole spacings minus one is the number missed
+ * - normal otherwise
+ * a gap of more than IR_SPACING_MAX_SKIP missed plantings is a stop (turn,
+ * refill), not skips: the lane learns again. so does a run of
+ * IR_SPACING_RELEARN doubles or skips in a row, which means the speed changed.
+ * o(1) per event, no divides.
+ */
+
+/* thresholds as fractions of the expected spacing, 8 fraction bits */
+#ifndef IR_SPACING_DOUBLE_Q8
+#define IR_SPACING_DOUBLE_Q8 128u /* 0.5 */
+#endif
+#ifndef IR_SPACING_SKIP_Q8
+#define IR_SPACING_SKIP_Q8 384u /* 1.5 */
+#endif
+
+/* most plantings one gap may have missed; longer gaps are stops */
+#ifndef IR_SPACING_MAX_SKIP
+#define IR_SPACING_MAX_SKIP 3u
+#endif
+
+/* doubles or skips in a row that make the lane learn its spacing again */
+#ifndef IR_SPACING_RELEARN
+#define IR_SPACING_RELEARN 4u
+#endif
+
+typedef enum
+{
+    IR_SPACING_NORMAL = 0,
+    IR_SPACING_DOUBLE,    /* second trigger of the same seedling */
+    IR_SPACING_SKIP_AFTER /* counted after one or more missed plantings */
+} ir_spacing_class_t;
+
+typedef struct
+{
+    uint32_t last_us; /* last break that counted as a seedling */
+    uint32_t exp_q;   /* expected spacing, 4 fraction bits; 0 while learning */
+    uint32_t seed[2]; /* first gaps while learning */
+    uint8_t gaps;     /* gaps seen while learning (0..2) */
+    uint8_t started;  /* last_us is valid */
+    uint8_t streak;   /* doubles or skips in a row */
+    uint8_t last;     /* ir_spacing_class_t of the last break */
+} ir_spacing_t;
+
+void ir_spacing_init(ir_spacing_t *s);
+
+/* classify a counted break at t_us (in order per lane); *missed = plantings
+ * missed before it (skip-after only, else 0)
+ */
+ir_spacing_class_t ir_spacing_event(ir_spacing_t *s, uint32_t t_us, uint32_t *missed);
+
+/* learned spacing in us, 0 while learning */
+uint32_t ir_spacing_expected_us(const ir_spacing_t *s);
+
+#endif /* IR_SPACING_H */
@@ -0,0 +1,127 @@
+#include "ir_stats.h"
+
+#define WINDOW_US ((uint32_t) IR_STATS_WINDOW_MS * 1000u)
+
+/* largest gap fed to the ewma, so gap << IR_STATS_Q and the signed
+ * difference in the update stay in 31 bits (~67 s with q4)
+ */
+#define GAP_CAP_US (1u << (30u - IR_STATS_Q))
+
+static void window_clear(ir_stats_window_t *w)
+{
+    w->gaps = 0;
+    w->gap_min_us = 0;
+    w->gap_max_us = 0;
+    for (uint32_t i = 0; i < IR_STATS_BINS; i++)
+    {
+        w->bins[i] = 0;
+    }
+}
+
+void ir_stats_init(ir_stats_t *s, uint32_t now_us)
+{
+    s->events = 0;
+    s->last_us = 0;
+    s->gap_avg_q = 0;
+    s->win_start_us = now_us;
+    window_clear(&s->cur);
+    window_clear(&s->done);
+}
+
+uint32_t ir_stats_bin(uint32_t gap_us)
+{
+    if (gap_us < (1u << IR_STATS_BIN_MIN_LOG2))
+        return 0;
+
+    /* octave from the top bit, half-octave from the bit below it */
+    uint32_t log2 = 31u - (uint32_t) __builtin_clz(gap_us);
+    uint32_t half = (gap_us >> (log2 - 1u)) & 1u;
+    uint32_t bin = ((log2 - IR_STATS_BIN_MIN_LOG2) << 1) + half + 1u;
+    return (bin < IR_STATS_BINS) ? bin : IR_STATS_BINS - 1u;
+}
+
+uint32_t ir_stats_bin_lo_us(uint32_t bin)
+{
+    if (bin == 0u)
+        return 0;
+
+    uint32_t log2 = IR_STATS_BIN_MIN_LOG2 + ((bin - 1u) >> 1);
+    return (1u << log2) + (((bin - 1u) & 1u) << (log2 - 1u));
+}
+
+void ir_stats_roll(ir_stats_t *s, uint32_t now_us)
+{
+    /* a break can be a little older than a window ir_get_stats() already
+     * rolled: it stays in the running window instead of wrapping to ~71 min
+     * elapsed. anything further behind is a long stop and rolls as usual
+     */
+    uint32_t behind = s->win_start_us - now_us;
+    if (behind != 0u && behind < WINDOW_US)
+        return;
+
+    uint32_t elapsed = now_us - s->win_start_us;
+    if (elapsed < WINDOW_US)
+        return;
+
+    /* the running window only holds events from its own span, so if more than
+     * one window went by the last complete one was empty
+     */
+    if (elapsed < 2u * WINDOW_US)
+        s->done = s->cur;
+    else
+        window_clear(&s->done);
+
+    window_clear(&s->cur);
+    s->win_start_us = now_us - (elapsed % WINDOW_US);
+}
+
+void ir_stats_event(ir_stats_t *s, uint32_t t_us)
+{
+    ir_stats_roll(s, t_us);
+
+    if (s->events != 0u)
+    {
+        uint32_t gap = t_us - s->last_us;
+        uint32_t x = ((gap < GAP_CAP_US) ? gap : GAP_CAP_US) << IR_STATS_Q;
+
+        if (s->events == 1u)
+            s->gap_avg_q = x;
+        else
+            s->gap_avg_q = (uint32_t) ((int32_t) s->gap_avg_q +
+                                       (((int32_t) x - (int32_t) s->gap_avg_q) >> IR_STATS_EWMA_SHIFT));
+
+        ir_stats_window_t *w = &s->cur;
+        if (w->gaps == 0u || gap < w->gap_min_us)
+            w->gap_min_us = gap;
+        if (gap > w->gap_max_us)
+            w->gap_max_us = gap;
+        w->gaps++;
+
+        uint16_t *b = &w->bins[ir_stats_bin(gap)];
+        if (*b != UINT16_MAX)
+            (*b)++;
+    }
+
+    if (s->events != UINT32_MAX)
+        s->events++;
+    s->last_us = t_us;
+}
+
+uint32_t ir_stats_gap_avg_us(const ir_stats_t *s)
+{
+    return (s->events < 2u) ? 0u : s->gap_avg_q >> IR_STATS_Q;
+}
+
+uint32_t ir_stats_rate_mhz(const ir_stats_t *s, uint32_t now_us)
+{
+    uint32_t gap = ir_stats_gap_avg_us(s);
+    if (gap == 0u)
+        return 0;
+
+    /* nothing for longer than the mean gap: the rate is at most 1 / that time */
+    uint32_t since = now_us - s->last_us;
+    if (since > gap)
+        gap = since;
+
+    return 1000000000u / gap;
+}
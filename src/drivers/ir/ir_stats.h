@@ -0,0 +1,76 @@
+#ifndef IR_STATS_H
+#define IR_STATS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* streaming per-channel statistics of counted breaks (integer only, no fpu)
+ * - rate: ewma of the inter-arrival gap (1/2^IR_STATS_EWMA_SHIFT, fixed point
+ *   with IR_STATS_Q fraction bits); a stall longer than the mean pulls the
+ *   rate down until the next event
+ * - gap histogram in half-octave bins (256 us .. ~1 s by default) plus
+ *   min/max gap, over fixed time windows: the running window fills while the
+ *   last complete one is reported
+ * - constant memory per channel, o(1) per event (a window roll clears one bank)
+ */
+
+/* ewma weight 1/2^n of a new gap */
+#ifndef IR_STATS_EWMA_SHIFT
+#define IR_STATS_EWMA_SHIFT 3u
+#endif
+
+/* fraction bits of the averaged gap */
+#define IR_STATS_Q 4u
+
+/* histogram: bin 0 holds gaps below 2^IR_STATS_BIN_MIN_LOG2 us, then two bins
+ * per octave; the last bin also takes everything above
+ */
+#ifndef IR_STATS_BINS
+#define IR_STATS_BINS 24u
+#endif
+#ifndef IR_STATS_BIN_MIN_LOG2
+#define IR_STATS_BIN_MIN_LOG2 8u
+#endif
+
+/* histogram window (ms) */
+#ifndef IR_STATS_WINDOW_MS
+#define IR_STATS_WINDOW_MS 10000u
+#endif
+
+typedef struct
+{
+    uint32_t gaps;       /* gaps seen in the window */
+    uint32_t gap_min_us; /* 0 when gaps == 0 */
+    uint32_t gap_max_us;
+    uint16_t bins[IR_STATS_BINS]; /* saturating */
+} ir_stats_window_t;
+
+typedef struct
+{
+    uint32_t events;        /* counted breaks seen (saturating) */
+    uint32_t last_us;       /* time of the last one */
+    uint32_t gap_avg_q;     /* ewma gap, IR_STATS_Q fraction bits */
+    uint32_t win_start_us;  /* start of the running window */
+    ir_stats_window_t cur;  /* running window */
+    ir_stats_window_t done; /* last complete window */
+} ir_stats_t;
+
+void ir_stats_init(ir_stats_t *s, uint32_t now_us);
+
+/* one counted break at t_us (timestamps in order per channel) */
+void ir_stats_event(ir_stats_t *s, uint32_t t_us);
+
+/* close the running window if it is over; call before reading done */
+void ir_stats_roll(ir_stats_t *s, uint32_t now_us);
+
+/* events per 1000 s (milli-hertz); 0 before the second event */
+uint32_t ir_stats_rate_mhz(const ir_stats_t *s, uint32_t now_us);
+
+/* mean gap in us; 0 before the second event */
+uint32_t ir_stats_gap_avg_us(const ir_stats_t *s);
+
+/* histogram bin of a gap, and the lowest gap (us) of a bin */
+uint32_t ir_stats_bin(uint32_t gap_us);
+uint32_t ir_stats_bin_lo_us(uint32_t bin);
+
+#endif /* IR_STATS_H */
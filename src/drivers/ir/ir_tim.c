@@ -0,0 +1,134 @@
+#include "ir.h"
+
+#if IR_BACKEND == IR_BACKEND_TIM2
+
+#include "ir_tim.h"
+#include "drivers/timebase/timebase.h"
+#include "drivers/prof/prof.h"
+
+/* tim2_ch1..ch3 sit on pa0..pa2: the channel table must be exactly that */
+#if IR_NUM_CHANNELS != 3 || IR_LINE_MASK != 0x7u
+#error "IR_BACKEND_TIM2 captures pa0..pa2 only; use the exti backend for other channel tables"
+#endif
+
+/* ring owned by ir.c, handed over in ir_tim_init() */
+static ir_ring_t *s_ring = NULL;
+static volatile uint32_t s_overcaptures = 0;
+
+/* per channel: ccrx, interrupt/capture flags */
+static volatile uint32_t *const s_ccr[ir_count] = {&TIM2->CCR1, &TIM2->CCR2, &TIM2->CCR3};
+static const uint32_t s_ccif[ir_count] = {TIM_SR_CC1IF, TIM_SR_CC2IF, TIM_SR_CC3IF};
+static const uint32_t s_ccof[ir_count] = {TIM_SR_CC1OF, TIM_SR_CC2OF, TIM_SR_CC3OF};
+static const uint32_t s_ccp[ir_count] = {TIM_CCER_CC1P, TIM_CCER_CC2P, TIM_CCER_CC3P};
+static const uint16_t s_pin[ir_count] = {GPIO_PIN_0, GPIO_PIN_1, GPIO_PIN_2};
+
+bool ir_tim_init(ir_ring_t *ring)
+{
+    if (!ring)
+        return false;
+    s_ring = ring;
+
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+    __HAL_RCC_TIM2_CLK_ENABLE();
+
+    /* tim2_ch1..3 default mapping is pa0..pa2; on f1 a timer input is a plain input */
+    GPIO_InitTypeDef gi = {0};
+    gi.Pin = GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2;
+    gi.Mode = GPIO_MODE_INPUT;
+    gi.Pull = GPIO_PULLUP; /* typical ir modules: open-collector low-active */
+    HAL_GPIO_Init(GPIOA, &gi);
+
+    TIM2->CR1 = 0;
+
+    /* 1 mhz free-running 16-bit counter; timer clock is 2 x pclk1 = hclk */
+    TIM2->PSC = (SystemCoreClock / 1000000U) - 1U;
+    TIM2->ARR = 0xFFFFU;
+
+    /* ckd = 4 → fdts = 18 mhz; the input filter samples at fdts / n */
+    TIM2->CR1 = TIM_CR1_CKD_1;
+
+    /* ccxs = 01 (input, icx → tix), no prescaler, icxf filter */
+    TIM2->CCMR1 = (1U << TIM_CCMR1_CC1S_Pos) | (IR_TIM_IC_FILTER << TIM_CCMR1_IC1F_Pos) |
+                  (1U << TIM_CCMR1_CC2S_Pos) | (IR_TIM_IC_FILTER << TIM_CCMR1_IC2F_Pos);
+    TIM2->CCMR2 = (1U << TIM_CCMR2_CC3S_Pos) | (IR_TIM_IC_FILTER << TIM_CCMR2_IC3F_Pos);
+
+    /* start on the falling edge (beam break = low); the isr flips ccxp after each
+     * capture, since f1 timers cannot capture both edges at once
+     */
+    TIM2->CCER = TIM_CCER_CC1E | TIM_CCER_CC1P | TIM_CCER_CC2E | TIM_CCER_CC2P | TIM_CCER_CC3E |
+                 TIM_CCER_CC3P;
+
+    TIM2->EGR = TIM_EGR_UG;
+    TIM2->SR = 0;
+    TIM2->DIER = TIM_DIER_CC1IE | TIM_DIER_CC2IE | TIM_DIER_CC3IE;
+
+    /* same priority the exti lines use */
+    HAL_NVIC_SetPriority(TIM2_IRQn, 10, 0);
+    HAL_NVIC_EnableIRQ(TIM2_IRQn);
+
+    TIM2->CR1 |= TIM_CR1_CEN;
+    return true;
+}
+
+void ir_tim_irq(void)
+{
+    PROF_SCOPE(tim_isr);
+
+    uint32_t sr = TIM2->SR;
+
+    /* reference point pairing the timer count with the microsecond clock */
+    uint16_t cnt = (uint16_t) TIM2->CNT;
+    uint32_t now = timebase_now_us();
+
+    /* sr bits are rc_w0: write 0 only to the overcapture flags we saw */
+    bool queued = false;
+
+    uint32_t of = sr & (TIM_SR_CC1OF | TIM_SR_CC2OF | TIM_SR_CC3OF);
+    if (of)
+    {
+        TIM2->SR = ~of;
+    }
+
+    for (uint32_t ch = 0; ch < (uint32_t) ir_count; ch++)
+    {
+        if (!(sr & s_ccif[ch]))
+            continue;
+
+        /* ccxp set = falling edge was armed, so the pin is now low */
+        uint8_t level = (TIM2->CCER & s_ccp[ch]) ? 0u : 1u;
+
+        /* reading ccrx clears ccxif; age is how long ago the edge was latched */
+        uint16_t age = (uint16_t) (cnt - (uint16_t) *s_ccr[ch]);
+        queued |= ir_ring_push(s_ring, now - age, (uint16_t) (1u << ch), (uint16_t) (level << ch));
+
+        /* arm the edge leaving the current pin level; if the opposite edge
+         * already happened before this point, queue it now so both sides stay in step
+         */
+        uint8_t pin = (GPIOA->IDR & s_pin[ch]) ? 1u : 0u;
+        if (pin != level)
+        {
+            queued |= ir_ring_push(s_ring, now, (uint16_t) (1u << ch), (uint16_t) (pin << ch));
+        }
+        if (pin)
+            TIM2->CCER |= s_ccp[ch];
+        else
+            TIM2->CCER &= ~s_ccp[ch];
+
+        if (sr & s_ccof[ch])
+        {
+            s_overcaptures++;
+        }
+    }
+
+    if (queued)
+    {
+        ir_on_pending();
+    }
+}
+
+uint32_t ir_tim_overcaptures(void)
+{
+    return s_overcaptures;
+}
+
+#endif /* IR_BACKEND == IR_BACKEND_TIM2 */
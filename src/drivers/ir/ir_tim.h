@@ -0,0 +1,30 @@
+#ifndef IR_TIM_H
+#define IR_TIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ir_ring.h"
+
+/* tim2 input-capture backend for pa0/pa1/pa2 (tim2_ch1..ch3)
+ * - edges are latched and noise-filtered by the timer (icxf), so the
+ *   capture timestamp does not depend on interrupt latency
+ * - the capture isr only converts ccrx to timebase_now_us and queues it, then
+ *   re-arms the opposite edge so the filter sees breaks and releases
+ * - enabled with IR_BACKEND=IR_BACKEND_TIM2; the exti path is then unused
+ */
+
+/* input filter (icxf, 0..15); 15 = fdts/32 with n=8 (~14 us at 72 mhz, ckd=4) */
+#ifndef IR_TIM_IC_FILTER
+#define IR_TIM_IC_FILTER 15u
+#endif
+
+/* configure pins, tim2 and its nvic line; captured edges go to ring */
+bool ir_tim_init(ir_ring_t *ring);
+
+/* capture interrupt body; called from TIM2_IRQHandler */
+void ir_tim_irq(void);
+
+/* edges lost because a capture register was overwritten before it was read */
+uint32_t ir_tim_overcaptures(void);
+
+#endif /* IR_TIM_H */
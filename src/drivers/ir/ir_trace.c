@@ -0,0 +1,111 @@
+#include "ir_trace.h"
+
+static inline void put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    p[2] = (uint8_t) (v >> 16);
+    p[3] = (uint8_t) (v >> 24);
+}
+
+static inline uint32_t get_u32(const uint8_t *p)
+{
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) |
+           ((uint32_t) p[3] << 24);
+}
+
+void ir_trace_enc_init(ir_trace_enc_t *enc, uint8_t channels)
+{
+    enc->last_us = 0;
+    enc->channels = channels;
+    enc->started = false;
+}
+
+uint32_t ir_trace_encode(ir_trace_enc_t *enc, const ir_event_t *e, uint8_t *out)
+{
+    uint32_t n = 0;
+
+    if (!enc->started)
+    {
+        /* the first edge defines t0, so its delta is zero */
+        put_u32(&out[0], IR_TRACE_MAGIC);
+        out[4] = (uint8_t) IR_TRACE_VERSION;
+        out[5] = enc->channels;
+        out[6] = 0;
+        out[7] = 0;
+        put_u32(&out[8], e->tick);
+        n = IR_TRACE_HDR_SIZE;
+
+        enc->last_us = e->tick;
+        enc->started = true;
+    }
+
+    uint64_t v = ((uint64_t) (e->tick - enc->last_us) << 5) |
+                 ((uint64_t) (e->level ? 1u : 0u) << 4) |
+                 (uint64_t) (e->channel & (IR_TRACE_MAX_CHANNELS - 1u));
+    enc->last_us = e->tick;
+
+    do
+    {
+        uint8_t b = (uint8_t) (v & 0x7Fu);
+        v >>= 7;
+        out[n++] = (v != 0u) ? (uint8_t) (b | 0x80u) : b;
+    } while (v != 0u);
+
+    return n;
+}
+
+bool ir_trace_dec_init(ir_trace_dec_t *dec, const uint8_t *data, uint32_t len)
+{
+    dec->p = data;
+    dec->end = data + len;
+    dec->tick = 0;
+    dec->channels = 0;
+    dec->truncated = false;
+
+    if (len < IR_TRACE_HDR_SIZE || get_u32(&data[0]) != IR_TRACE_MAGIC ||
+        data[4] != IR_TRACE_VERSION || data[5] == 0u || data[5] > IR_TRACE_MAX_CHANNELS)
+    {
+        return false;
+    }
+
+    dec->channels = data[5];
+    dec->tick = get_u32(&data[8]);
+    dec->p = data + IR_TRACE_HDR_SIZE;
+    return true;
+}
+
+bool ir_trace_next(ir_trace_dec_t *dec, ir_event_t *out)
+{
+    uint64_t v = 0;
+    uint32_t shift = 0;
+
+    for (;;)
+    {
+        if (dec->p >= dec->end)
+        {
+            /* clean end only on a record boundary */
+            dec->truncated = (shift != 0u);
+            return false;
+        }
+        if (shift >= 7u * IR_TRACE_REC_MAX)
+        {
+            dec->truncated = true;
+            return false;
+        }
+
+        uint8_t b = *dec->p++;
+        v |= (uint64_t) (b & 0x7Fu) << shift;
+        shift += 7u;
+        if (!(b & 0x80u))
+        {
+            break;
+        }
+    }
+
+    dec->tick += (uint32_t) (v >> 5);
+    out->tick = dec->tick;
+    out->channel = (uint8_t) (v & (IR_TRACE_MAX_CHANNELS - 1u));
+    out->level = (uint8_t) ((v >> 4) & 1u);
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef IR_TRACE_H
+#define IR_TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ir_ring.h"
+
+/* compact binary trace of raw ir edges (before debounce), for replaying field runs
+ *
+ * stream = header, record*   (all multi-byte fields little endian)
+ *
+ * header, IR_TRACE_HDR_SIZE bytes:
+ *   u32 magic    IR_TRACE_MAGIC ("IRTR")
+ *   u8  version  IR_TRACE_VERSION
+ *   u8  channels number of ir channels on the recorder
+ *   u16 reserved 0
+ *   u32 t0_us    timestamp the first delta is taken from
+ *
+ * record: uleb128 of (delta_us << 5) | (level << 4) | channel
+ *   delta_us is the distance to the previous edge of any channel (mod 2^32),
+ *   so a typical edge costs 2..3 bytes and never more than IR_TRACE_REC_MAX
+ */
+
+#define IR_TRACE_MAGIC 0x52545249u /* "IRTR" */
+#define IR_TRACE_VERSION 1u
+#define IR_TRACE_HDR_SIZE 12u
+#define IR_TRACE_REC_MAX 6u /* 37-bit value in 7-bit groups */
+#define IR_TRACE_MAX_CHANNELS 16u
+
+/* encoder: the header is emitted in front of the first record */
+typedef struct
+{
+    uint32_t last_us;
+    uint8_t channels;
+    bool started;
+} ir_trace_enc_t;
+
+void ir_trace_enc_init(ir_trace_enc_t *enc, uint8_t channels);
+
+/* append one edge to out (room for IR_TRACE_HDR_SIZE + IR_TRACE_REC_MAX bytes);
+ * returns bytes written
+ */
+uint32_t ir_trace_encode(ir_trace_enc_t *enc, const ir_event_t *e, uint8_t *out);
+
+/* decoder over an in-memory trace */
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    uint32_t tick;
+    uint8_t channels;
+    bool truncated; /* stream ended inside a record */
+} ir_trace_dec_t;
+
+/* parse the header; false if the magic or version does not match */
+bool ir_trace_dec_init(ir_trace_dec_t *dec, const uint8_t *data, uint32_t len);
+
+/* next edge with its absolute timestamp; false at the end of the stream */
+bool ir_trace_next(ir_trace_dec_t *dec, ir_event_t *out);
+
+#endif /* IR_TRACE_H */
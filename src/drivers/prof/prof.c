@@ -0,0 +1,148 @@
+#include "drivers/prof/prof.h"
+
+#if PROF_ENABLE
+
+#include "stm32f1xx_hal.h"
+#ifdef SPROUT_SIM
+#include <time.h>
+#endif
+
+static prof_stat_t s_stat[PROF_COUNT];
+
+static const char *const s_names[PROF_COUNT] = {
+#define PROF_NAME(name) #name,
+        PROF_PROBES(PROF_NAME)
+#undef PROF_NAME
+};
+
+#ifdef SPROUT_SIM
+uint32_t prof_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) ((uint64_t) ts.tv_sec * 1000000000u + (uint64_t) ts.tv_nsec);
+}
+#endif
+
+uint32_t prof_ticks_per_us(void)
+{
+#ifdef SPROUT_SIM
+    return 1000u;
+#else
+    return SystemCoreClock / 1000000U;
+#endif
+}
+
+void prof_record(prof_id_t id, uint32_t ticks)
+{
+    if ((uint32_t) id >= (uint32_t) PROF_COUNT)
+        return;
+
+    /* a probe may be hit from thread mode and an isr; keep the update whole */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    prof_stat_t *s = &s_stat[id];
+    if (s->count == 0u || ticks < s->min)
+        s->min = ticks;
+    if (ticks > s->max)
+        s->max = ticks;
+    s->sum += ticks;
+    s->count++;
+
+    __set_PRIMASK(primask);
+}
+
+bool prof_get(prof_id_t id, prof_stat_t *out)
+{
+    if ((uint32_t) id >= (uint32_t) PROF_COUNT || !out)
+        return false;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *out = s_stat[id];
+    __set_PRIMASK(primask);
+    return true;
+}
+
+const char *prof_name(prof_id_t id)
+{
+    return ((uint32_t) id < (uint32_t) PROF_COUNT) ? s_names[id] : "?";
+}
+
+void prof_reset(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    for (uint32_t i = 0; i < (uint32_t) PROF_COUNT; i++)
+    {
+        s_stat[i] = (prof_stat_t){0};
+    }
+    __set_PRIMASK(primask);
+}
+
+/* bounded string builder, no printf */
+static uint32_t put_str(char *buf, uint32_t pos, uint32_t len, const char *s)
+{
+    while (*s && pos + 1u < len)
+    {
+        buf[pos++] = *s++;
+    }
+    return pos;
+}
+
+static uint32_t put_u32(char *buf, uint32_t pos, uint32_t len, uint32_t v)
+{
+    char tmp[10];
+    uint32_t n = 0;
+    do
+    {
+        tmp[n++] = (char) ('0' + (v % 10u));
+        v /= 10u;
+    } while (v != 0u);
+    while (n && pos + 1u < len)
+    {
+        buf[pos++] = tmp[--n];
+    }
+    return pos;
+}
+
+uint32_t prof_format(prof_id_t id, char *buf, uint32_t len)
+{
+    prof_stat_t s;
+    if (!buf || len == 0u || !prof_get(id, &s))
+        return 0;
+
+    uint32_t mean = s.count ? (uint32_t) (s.sum / s.count) : 0u;
+
+    uint32_t p = put_str(buf, 0, len, prof_name(id));
+    p = put_str(buf, p, len, " n");
+    p = put_u32(buf, p, len, s.count);
+    p = put_str(buf, p, len, " ");
+    p = put_u32(buf, p, len, s.min);
+    p = put_str(buf, p, len, "/");
+    p = put_u32(buf, p, len, mean);
+    p = put_str(buf, p, len, "/");
+    p = put_u32(buf, p, len, s.max);
+    buf[p] = '\0';
+    return p;
+}
+
+void prof_dump(void (*line)(const char *s, void *ctx), void *ctx)
+{
+    if (!line)
+        return;
+
+    char buf[48];
+    for (uint32_t i = 0; i < (uint32_t) PROF_COUNT; i++)
+    {
+        prof_stat_t s;
+        if (prof_get((prof_id_t) i, &s) && s.count != 0u)
+        {
+            (void) prof_format((prof_id_t) i, buf, sizeof(buf));
+            line(buf, ctx);
+        }
+    }
+}
+
+#endif /* PROF_ENABLE */
@@ -0,0 +1,120 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* cycle profiling probes for driver entry points
+ * - fixed probe table (PROF_PROBES), count/min/max/sum per probe, no heap
+ * - ticks are dwt->cyccnt cycles on the target and clock_gettime
+ *   nanoseconds in the host simulator (SPROUT_SIM)
+ * - PROF_ENABLE=0 (cmake -DSPROUT_PROF=OFF) turns every macro into nothing
+ *   and drops the table
+ *
+ * usage:
+ *   void f(void) { PROF_SCOPE(i2c_write); ... }        // until f returns
+ *   PROF_BEGIN(gpio_isr); ...; PROF_END(gpio_isr);      // explicit span
+ */
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 0
+#endif
+
+#if PROF_ENABLE && !defined(SPROUT_SIM)
+#include "stm32f1xx_hal.h"
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* probe list; add a name here to get a PROF_<name> slot */
+#define PROF_PROBES(X) \
+    X(exti_isr)        \
+    X(gpio_isr)        \
+    X(tim_isr)         \
+    X(ir_process)      \
+    X(i2c_write)       \
+    X(i2c_write_dma)   \
+    X(i2c_recover)     \
+    X(u8x8_byte)       \
+    X(display_frame)   \
+    X(display_counts)
+
+    typedef enum
+    {
+#define PROF_ID(name) PROF_##name,
+        PROF_PROBES(PROF_ID)
+#undef PROF_ID
+        PROF_COUNT
+    } prof_id_t;
+
+#if PROF_ENABLE
+
+    typedef struct
+    {
+        uint32_t count;
+        uint32_t min;
+        uint32_t max;
+        uint64_t sum; /* mean = sum / count */
+    } prof_stat_t;
+
+    /* free-running tick counter the probes subtract */
+#ifdef SPROUT_SIM
+    uint32_t prof_now(void);
+#else
+    static inline uint32_t prof_now(void)
+    {
+        return DWT->CYCCNT;
+    }
+#endif
+
+    /* ticks per microsecond (hclk mhz on target, 1000 on the host) */
+    uint32_t prof_ticks_per_us(void);
+
+    /* fold one measurement into a probe; callable from isrs */
+    void prof_record(prof_id_t id, uint32_t ticks);
+
+    bool prof_get(prof_id_t id, prof_stat_t *out);
+    const char *prof_name(prof_id_t id);
+    void prof_reset(void);
+
+    /* format probe id as "name n<count> <min>/<avg>/<max>" (ticks); returns length */
+    uint32_t prof_format(prof_id_t id, char *buf, uint32_t len);
+
+    /* one prof_format() line per probe that has samples, e.g. to a debug
+     * channel, or collect them for display_write_lines()
+     */
+    void prof_dump(void (*line)(const char *s, void *ctx), void *ctx);
+
+    typedef struct
+    {
+        uint32_t t0;
+        uint8_t id;
+    } prof_scope_t;
+
+    static inline void prof_scope_end(prof_scope_t *s)
+    {
+        prof_record((prof_id_t) s->id, prof_now() - s->t0);
+    }
+
+#define PROF_BEGIN(name) uint32_t prof_t0_##name = prof_now()
+#define PROF_END(name) prof_record(PROF_##name, prof_now() - prof_t0_##name)
+#define PROF_SCOPE(name)                                                        \
+    prof_scope_t prof_scope_##name __attribute__((cleanup(prof_scope_end))) = { \
+            prof_now(), (uint8_t) PROF_##name}
+
+#else /* !PROF_ENABLE */
+
+#define PROF_BEGIN(name) ((void) 0)
+#define PROF_END(name) ((void) 0)
+#define PROF_SCOPE(name) ((void) 0)
+
+#endif /* PROF_ENABLE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PROF_H */
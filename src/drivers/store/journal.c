@@ -0,0 +1,269 @@
+#include "journal.h"
+#include <string.h>
+
+/* flash is memory mapped on the target; the sim keeps its fake in host memory */
+#ifdef SPROUT_SIM
+#define FLASH_AT(addr) sim_flash_ptr(addr)
+#else
+#define FLASH_AT(addr) ((const uint8_t *) (uintptr_t) (addr))
+#endif
+
+#define MAGIC 0x4C4E524Au /* "JRNL" */
+#define HDR_SIZE 8u       /* epoch, magic */
+#define BLANK 0xFFFFFFFFu
+
+static uint32_t rd32(uint32_t addr)
+{
+    uint32_t v;
+    memcpy(&v, FLASH_AT(addr), sizeof(v));
+    return v;
+}
+
+/* crc-32 (ieee, reflected), a nibble at a time: 64 bytes of table */
+static uint32_t crc32(const uint8_t *p, uint32_t n)
+{
+    static const uint32_t t[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u,
+        0x4DB26158u, 0x5005713Cu, 0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu,
+        0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu,
+    };
+    uint32_t c = 0xFFFFFFFFu;
+    while (n--)
+    {
+        c ^= *p++;
+        c = (c >> 4) ^ t[c & 15u];
+        c = (c >> 4) ^ t[c & 15u];
+    }
+    return ~c;
+}
+
+static inline uint32_t page_addr(const journal_t *j, uint8_t page)
+{
+    return j->base + (uint32_t) page * JOURNAL_PAGE_SIZE;
+}
+
+static inline uint32_t slot_addr(const journal_t *j, uint8_t page, uint16_t k)
+{
+    return page_addr(j, page) + HDR_SIZE + (uint32_t) k * j->slot;
+}
+
+static inline uint8_t next_page(const journal_t *j, uint8_t page)
+{
+    return (uint8_t) ((page + 1u) % j->pages);
+}
+
+/* header written completely: the magic goes last */
+static bool header_ok(const journal_t *j, uint8_t page, uint32_t *epoch)
+{
+    uint32_t a = page_addr(j, page);
+    *epoch = rd32(a);
+    return rd32(a + 4u) == MAGIC && *epoch != BLANK;
+}
+
+static bool page_blank(const journal_t *j, uint8_t page)
+{
+    uint32_t a = page_addr(j, page);
+    for (uint32_t off = 0; off < JOURNAL_PAGE_SIZE; off += 4u)
+    {
+        if (rd32(a + off) != BLANK)
+            return false;
+    }
+    return true;
+}
+
+static bool slot_valid(const journal_t *j, uint32_t addr)
+{
+    uint32_t body = j->slot - 4u;
+    uint32_t seq = rd32(addr);
+    return seq != BLANK && crc32(FLASH_AT(addr), body) == rd32(addr + body);
+}
+
+/* slots fill in order and a used slot never reads blank: first blank one */
+static uint16_t first_blank(const journal_t *j, uint8_t page)
+{
+    uint16_t lo = 0;
+    uint16_t hi = j->per_page;
+    while (lo < hi)
+    {
+        uint16_t mid = (uint16_t) ((lo + hi) / 2u);
+        if (rd32(slot_addr(j, page, mid)) == BLANK)
+            hi = mid;
+        else
+            lo = (uint16_t) (mid + 1u);
+    }
+    return lo;
+}
+
+/* newest valid record in page below slot end; 0 if none */
+static uint32_t last_valid(journal_t *j, uint8_t page, uint16_t end)
+{
+    while (end > 0u)
+    {
+        uint32_t a = slot_addr(j, page, --end);
+        if (slot_valid(j, a))
+            return a;
+        j->stats.torn++;
+    }
+    return 0;
+}
+
+static bool program(uint32_t addr, const uint8_t *src, uint32_t n)
+{
+    bool ok = true;
+    (void) HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < n && ok; i += 2u)
+    {
+        uint16_t hw = (uint16_t) (src[i] | ((uint16_t) src[i + 1u] << 8));
+        ok = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, addr + i, hw) == HAL_OK;
+    }
+    (void) HAL_FLASH_Lock();
+    return ok;
+}
+
+journal_status_t journal_open(journal_t *j, uint32_t base, uint8_t pages, uint16_t len)
+{
+    if (!j || pages < 2u || len == 0u || len > JOURNAL_MAX_PAYLOAD)
+        return JOURNAL_PARAM;
+
+    memset(j, 0, sizeof(*j));
+    j->base = base;
+    j->pages = pages;
+    j->len = len;
+    j->slot = (uint16_t) (4u + ((len + 3u) & ~3u) + 4u);
+    j->per_page = (uint16_t) ((JOURNAL_PAGE_SIZE - HDR_SIZE) / j->slot);
+
+    /* newest page in use */
+    bool found = false;
+    for (uint8_t p = 0; p < pages; p++)
+    {
+        uint32_t e;
+        if (header_ok(j, p, &e) && (!found || (int32_t) (e - j->epoch) > 0))
+        {
+            found = true;
+            j->page = p;
+            j->epoch = e;
+        }
+    }
+
+    if (!found)
+    {
+        /* nothing yet: the first append opens page 0 */
+        j->page = (uint8_t) (pages - 1u);
+        j->next = j->per_page;
+    }
+    else
+    {
+        j->next = first_blank(j, j->page);
+
+        /* newest record: this page, else the ones before it, newest first */
+        uint8_t p = j->page;
+        uint32_t e = j->epoch;
+        uint16_t end = j->next;
+        for (uint8_t n = 0; n < pages; n++)
+        {
+            j->latest = last_valid(j, p, end);
+            if (j->latest != 0u)
+                break;
+
+            p = (uint8_t) ((p + pages - 1u) % pages);
+            uint32_t pe;
+            if (!header_ok(j, p, &pe) || pe != --e)
+                break;
+            end = first_blank(j, p);
+        }
+        if (j->latest != 0u)
+            j->seq = rd32(j->latest);
+    }
+
+    j->spare = page_blank(j, next_page(j, j->page));
+    return (j->latest != 0u) ? JOURNAL_OK : JOURNAL_EMPTY;
+}
+
+journal_status_t journal_read(const journal_t *j, void *out)
+{
+    if (!j || !out)
+        return JOURNAL_PARAM;
+    if (j->latest == 0u)
+        return JOURNAL_EMPTY;
+    memcpy(out, FLASH_AT(j->latest + 4u), j->len);
+    return JOURNAL_OK;
+}
+
+journal_status_t journal_append(journal_t *j, const void *payload)
+{
+    if (!j || !payload || j->slot == 0u)
+        return JOURNAL_PARAM;
+
+    if (j->next >= j->per_page)
+    {
+        if (!j->spare)
+            return JOURNAL_WAIT;
+
+        /* open the erased page: epoch first, the magic commits the header */
+        uint8_t p = next_page(j, j->page);
+        uint32_t hdr[2] = {j->epoch + 1u, MAGIC};
+        j->spare = false;
+        if (!program(page_addr(j, p), (const uint8_t *) hdr, sizeof(hdr)))
+        {
+            j->stats.errors++;
+            return JOURNAL_ERROR;
+        }
+        j->page = p;
+        j->epoch++;
+        j->next = 0;
+        j->spare = page_blank(j, next_page(j, p));
+    }
+
+    /* seq, payload (zero padded), crc; a failed slot stays used */
+    uint32_t rec[(4u + JOURNAL_MAX_PAYLOAD + 4u) / 4u + 1u] = {0};
+    uint32_t body = j->slot - 4u;
+    uint32_t addr = slot_addr(j, j->page, j->next++);
+    rec[0] = j->seq + 1u;
+    memcpy(&rec[1], payload, j->len);
+    rec[body / 4u] = crc32((const uint8_t *) rec, body);
+
+    if (!program(addr, (const uint8_t *) rec, j->slot))
+    {
+        j->stats.errors++;
+        return JOURNAL_ERROR;
+    }
+    j->seq = rec[0];
+    j->latest = addr;
+    j->stats.appended++;
+    return JOURNAL_OK;
+}
+
+bool journal_erase_due(const journal_t *j)
+{
+    if (!j || j->slot == 0u || j->spare)
+        return false;
+
+    /* never the page holding the newest record */
+    uint8_t p = next_page(j, j->page);
+    return j->latest == 0u || (j->latest - j->base) / JOURNAL_PAGE_SIZE != p;
+}
+
+journal_status_t journal_erase_next(journal_t *j)
+{
+    if (!journal_erase_due(j))
+        return JOURNAL_PARAM;
+
+    FLASH_EraseInitTypeDef er = {0};
+    er.TypeErase = FLASH_TYPEERASE_PAGES;
+    er.PageAddress = page_addr(j, next_page(j, j->page));
+    er.NbPages = 1;
+    uint32_t bad = 0;
+
+    (void) HAL_FLASH_Unlock();
+    HAL_StatusTypeDef st = HAL_FLASHEx_Erase(&er, &bad);
+    (void) HAL_FLASH_Lock();
+
+    if (st != HAL_OK || bad != BLANK)
+    {
+        j->stats.errors++;
+        return JOURNAL_ERROR;
+    }
+    j->stats.erases++;
+    j->spare = true;
+    return JOURNAL_OK;
+}
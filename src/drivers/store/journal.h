@@ -0,0 +1,98 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f1xx_hal.h"
+
+/* append-only journal of fixed-size records in reserved flash pages
+ * - each page starts with a header (epoch, then a magic word written last);
+ *   pages are filled in turn and erased round robin, so every page sees the
+ *   same number of erase cycles
+ * - a record is seq, payload and a crc-32 over both, programmed in that
+ *   order: a power cut part way leaves a slot that is used but fails its crc
+ * - open: the page with the newest epoch (page headers only), the first
+ *   blank slot in it by binary search (slots fill in order), then back to the
+ *   last record whose crc holds. no full scan
+ * - appending never erases. the next page is erased ahead of time by
+ *   journal_erase_next(), which stalls the core (flash is busy for 20-40 ms
+ *   on the f103), so the caller picks a moment when nothing is lost by it
+ * main loop only
+ */
+
+/* journal region: the last JOURNAL_PAGES pages of the 64 kb part. the JOURNAL
+ * region of the linker script reserves the same pages; keep the two in step
+ */
+#ifndef JOURNAL_BASE
+#define JOURNAL_BASE 0x0800F000u
+#endif
+#ifndef JOURNAL_PAGES
+#define JOURNAL_PAGES 4u
+#endif
+
+#define JOURNAL_PAGE_SIZE FLASH_PAGE_SIZE
+
+/* largest payload (bytes) */
+#ifndef JOURNAL_MAX_PAYLOAD
+#define JOURNAL_MAX_PAYLOAD 128u
+#endif
+
+#if JOURNAL_PAGES < 2u
+#error "the journal needs at least 2 pages (one is erased while the other holds the newest record)"
+#endif
+
+typedef enum
+{
+    JOURNAL_OK = 0,
+    JOURNAL_EMPTY, /* no valid record */
+    JOURNAL_WAIT,  /* page full, the next one is not erased yet */
+    JOURNAL_ERROR, /* flash program or erase failed */
+    JOURNAL_PARAM
+} journal_status_t;
+
+typedef struct
+{
+    uint32_t appended; /* records written */
+    uint32_t erases;   /* pages erased */
+    uint32_t torn;     /* slots skipped at open: used but failing their crc */
+    uint32_t errors;   /* failed programs or erases */
+} journal_stats_t;
+
+typedef struct
+{
+    uint32_t base;      /* flash address of page 0 */
+    uint16_t len;       /* payload bytes */
+    uint16_t slot;      /* record bytes in flash */
+    uint16_t per_page;  /* record slots per page */
+    uint16_t next;      /* next slot to write in page (per_page = full) */
+    uint8_t pages;
+    uint8_t page;       /* page being appended to */
+    uint8_t spare;      /* the page after it is erased */
+    uint32_t epoch;     /* header epoch of page (0 = no page in use yet) */
+    uint32_t seq;       /* seq of the newest record (0 = none) */
+    uint32_t latest;    /* flash address of the newest record (0 = none) */
+    journal_stats_t stats;
+} journal_t;
+
+/* find the newest record in pages at base; len = payload bytes (1 ..
+ * JOURNAL_MAX_PAYLOAD). JOURNAL_EMPTY is a usable, empty journal
+ */
+journal_status_t journal_open(journal_t *j, uint32_t base, uint8_t pages, uint16_t len);
+
+/* copy the newest payload; JOURNAL_EMPTY if there is none */
+journal_status_t journal_read(const journal_t *j, void *out);
+
+/* append one payload (len bytes). programs halfwords one at a time, so an
+ * interrupt waits for at most one of them; never erases
+ */
+journal_status_t journal_append(journal_t *j, const void *payload);
+
+/* the next page wants erasing: it is not erased yet and does not hold the
+ * newest record
+ */
+bool journal_erase_due(const journal_t *j);
+
+/* erase the next page now. stalls the core for the whole page erase */
+journal_status_t journal_erase_next(journal_t *j);
+
+#endif /* JOURNAL_H */
@@ -0,0 +1,116 @@
+#include "drivers/store/store.h"
+#include "drivers/ir/ir.h"
+#include <string.h>
+
+/* one checkpoint: what ir_restore() takes back */
+typedef struct
+{
+    uint32_t count[ir_count];
+    uint32_t corrected[ir_count];
+    uint32_t objects;
+} checkpoint_t;
+
+static journal_t s_journal;
+static bool s_open = false;
+static bool s_flush = false;     /* write at the next poll, period or not */
+static uint32_t s_saved_seq = 0; /* ir snapshot seq on flash */
+static uint32_t s_seen_seq = 0;  /* ir snapshot seq at the last poll */
+static uint32_t s_last_ms = 0;   /* last checkpoint written */
+static uint32_t s_change_ms = 0; /* last poll that saw the counts change */
+static store_stats_t s_stats;
+
+bool store_init(void)
+{
+    store_stats_t zero = {0};
+    s_stats = zero;
+    s_flush = false;
+    /* the first change after boot is written at once */
+    s_last_ms = HAL_GetTick() - STORE_PERIOD_MS;
+
+    journal_status_t st = journal_open(&s_journal, JOURNAL_BASE, JOURNAL_PAGES, sizeof(checkpoint_t));
+    s_open = (st == JOURNAL_OK || st == JOURNAL_EMPTY);
+    if (!s_open)
+        return false;
+
+    checkpoint_t cp;
+    if (journal_read(&s_journal, &cp) == JOURNAL_OK)
+    {
+        ir_snapshot_t snap = {0};
+        memcpy(snap.count, cp.count, sizeof(snap.count));
+        memcpy(snap.corrected, cp.corrected, sizeof(snap.corrected));
+        snap.objects = cp.objects;
+        if (ir_restore(&snap))
+            s_stats.restored = s_journal.seq;
+    }
+
+    /* what was just restored is on flash already */
+    ir_snapshot_t now;
+    if (ir_snapshot(&now))
+        s_saved_seq = now.seq;
+    s_seen_seq = s_saved_seq;
+    return true;
+}
+
+void store_flush(void)
+{
+    s_flush = true;
+}
+
+void store_service(uint32_t now_ms)
+{
+    if (!s_open)
+        return;
+
+    ir_snapshot_t snap;
+    bool have = ir_snapshot(&snap);
+    if (have && snap.seq != s_seen_seq)
+    {
+        s_seen_seq = snap.seq;
+        s_change_ms = now_ms;
+    }
+
+    uint32_t since = now_ms - s_last_ms;
+    bool paused = (now_ms - s_change_ms) >= STORE_PAUSE_MS;
+    if (have && snap.seq != s_saved_seq &&
+        (s_flush || since >= STORE_PERIOD_MS || (paused && since >= STORE_MIN_MS)))
+    {
+        checkpoint_t cp;
+        memcpy(cp.count, snap.count, sizeof(cp.count));
+        memcpy(cp.corrected, snap.corrected, sizeof(cp.corrected));
+        cp.objects = snap.objects;
+
+        switch (journal_append(&s_journal, &cp))
+        {
+            case JOURNAL_OK:
+                s_saved_seq = snap.seq;
+                s_last_ms = now_ms;
+                s_flush = false;
+                s_stats.written++;
+                break;
+            case JOURNAL_WAIT:
+                /* next poll, once the erase below got its quiet slot */
+                s_stats.waits++;
+                break;
+            default:
+                /* the slot is spent; try again after STORE_MIN_MS */
+                s_last_ms = now_ms;
+                break;
+        }
+    }
+
+    /* erase ahead, while no lane expects a break for the whole erase */
+    if (journal_erase_due(&s_journal))
+    {
+        if (ir_quiet_us() >= STORE_ERASE_QUIET_US)
+            (void) journal_erase_next(&s_journal);
+        else
+            s_stats.erase_held++;
+    }
+}
+
+store_stats_t store_get_stats(void)
+{
+    store_stats_t st = s_stats;
+    st.journal = s_journal.stats;
+    return st;
+}
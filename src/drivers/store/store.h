@@ -0,0 +1,76 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "journal.h"
+
+/* count checkpoints in the flash journal (journal.h), so a brown-out costs
+ * at most STORE_PERIOD_MS of counting
+ * - boot: the newest checkpoint is loaded back into the counters
+ * - a checkpoint is written when the counts changed: once they stay put for
+ *   STORE_PAUSE_MS (end of a row, a stop), else after STORE_PERIOD_MS of
+ *   steady counting; never twice within STORE_MIN_MS (store_flush() skips
+ *   all of that once)
+ * - the next journal page is erased ahead of time, but only while the ir
+ *   lanes expect no edge for STORE_ERASE_QUIET_US (ir_quiet_us()): the erase
+ *   stalls the core, exti vectors included
+ * main loop only
+ *
+ * wear: a checkpoint of 3 channels is a 36-byte slot, 28 per page, so the
+ * 4 journal pages take 112 checkpoints per erase cycle and, at the f103's
+ * 10k cycles, 1.12 million in all. counting time until then:
+ * - steady counting, one per STORE_PERIOD_MS (60 s): ~18700 h
+ * - worst case, a pause every STORE_MIN_MS (20 s): ~6200 h
+ * - idle: nothing is written
+ */
+
+/* longest a change waits while the counts keep changing (ms) */
+#ifndef STORE_PERIOD_MS
+#define STORE_PERIOD_MS 60000u
+#endif
+
+/* counts unchanged this long: the line paused, write now (ms) */
+#ifndef STORE_PAUSE_MS
+#define STORE_PAUSE_MS 2000u
+#endif
+
+/* least time between two checkpoints; bounds the wear (ms) */
+#ifndef STORE_MIN_MS
+#define STORE_MIN_MS 20000u
+#endif
+
+#if STORE_MIN_MS > STORE_PERIOD_MS
+#error "STORE_MIN_MS must not exceed STORE_PERIOD_MS"
+#endif
+
+/* quiet time an erase needs: 40 ms page erase (f103 max) plus margin */
+#ifndef STORE_ERASE_QUIET_US
+#define STORE_ERASE_QUIET_US 50000u
+#endif
+
+typedef struct
+{
+    uint32_t restored;   /* seq of the checkpoint loaded at boot (0 = none) */
+    uint32_t written;    /* checkpoints written */
+    uint32_t waits;      /* checkpoints held back: page full, erase not done */
+    uint32_t erase_held; /* polls where an erase was due but the lanes were busy */
+    journal_stats_t journal;
+} store_stats_t;
+
+/* open the journal and restore the counters from the newest checkpoint;
+ * after ir_init(). false if the journal could not be used
+ */
+bool store_init(void);
+
+/* write the next checkpoint without waiting for the period, e.g. after a
+ * reset, so a closed batch does not come back after a power cut
+ */
+void store_flush(void);
+
+/* poll from a periodic task: write a checkpoint or erase ahead when due */
+void store_service(uint32_t now_ms);
+
+store_stats_t store_get_stats(void);
+
+#endif /* STORE_H */
@@ -2,6 +2,7 @@
 #include "gpio.h"
 #include "drivers/i2c/i2c.h"
 #include "drivers/display/display.h"
+#include "drivers/timebase/timebase.h"
 
 /* bluepill user led on pc13 (active low) */
 static const gpio_pin_t s_led_pc13 = {GPIOC, GPIO_PIN_13};
@@ -91,16 +92,22 @@ void system_init(void)
     /* configure clock tree (72 mhz by default) */
     system_clock_config();
 
+    /* microsecond timebase on dwt->cyccnt (needs the final hclk) */
+    (void) timebase_init();
+
     /* configure board gpios: user led on pc13 (active low) */
     if (gpio_setup_output(&s_led_pc13, GPIO_SPEED_FREQ_LOW, /*initial_on=*/false) != gpio_ok)
     {
         system_error_loop();
     }
 
-    /* init i2c1 on pb6/pb7 @ 400 khz; no remap */
+    /* init i2c1 on pb6/pb7 @ 400 khz; no remap. duty 2:1 because pclk1 is
+     * 36 mhz: 16:9 would only reach 360 khz (see i2c_duty_t)
+     */
     {
         i2c_config_t cfg = {.instance = I2C1,
                             .clock_speed_hz = 400000,
+                            .duty = I2C_DUTY_2,
                             .scl_port = GPIOB,
                             .scl_pin = GPIO_PIN_6,
                             .sda_port = GPIOB,
@@ -0,0 +1,56 @@
+#include "drivers/timebase/timebase.h"
+#include "stm32f1xx_hal.h"
+
+static timebase_state_t s_tb;
+static bool s_ready = false;
+
+bool timebase_init(void)
+{
+    /* dwt needs the trace block enabled before the counter will run */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    timebase_state_init(&s_tb, DWT->CYCCNT, SystemCoreClock / 1000000U);
+    s_ready = true;
+    __set_PRIMASK(primask);
+
+    return true;
+}
+
+void timebase_tick(void)
+{
+    if (!s_ready)
+        return;
+
+    /* exti isrs may preempt systick and read the base; keep the update atomic */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    timebase_state_advance(&s_tb, DWT->CYCCNT);
+    __set_PRIMASK(primask);
+}
+
+uint32_t timebase_cycles(void)
+{
+    return DWT->CYCCNT;
+}
+
+uint32_t timebase_now_us(void)
+{
+    return (uint32_t) timebase_now_us64();
+}
+
+uint64_t timebase_now_us64(void)
+{
+    if (!s_ready)
+        return 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t us = timebase_state_us64(&s_tb, DWT->CYCCNT);
+    __set_PRIMASK(primask);
+
+    return us;
+}
@@ -0,0 +1,79 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* monotonic microsecond clock on top of the dwt cycle counter
+     * - dwt->cyccnt runs at hclk and wraps every ~59 s at 72 mhz
+     * - timebase_tick() folds elapsed cycles into a microsecond base, so a read
+     *   is one 32-bit subtract + divide and never sees a raw counter wrap
+     * - the 64-bit value extends the 32-bit us count (wraps every ~71 min)
+     */
+
+    /* extension state; kept public so the wrap logic can run on a fake counter
+     * (sim/sim_timewrap.c drives it across both wraps)
+     */
+    typedef struct
+    {
+        uint32_t cyc_base;   /* raw counter value that matches us_base */
+        uint32_t us_base;    /* microseconds at cyc_base, low word */
+        uint32_t us_high;    /* microseconds at cyc_base, high word */
+        uint32_t cyc_per_us; /* counter ticks per microsecond (72 at 72 mhz) */
+    } timebase_state_t;
+
+    static inline void timebase_state_init(timebase_state_t *s, uint32_t raw, uint32_t cyc_per_us)
+    {
+        s->cyc_base = raw;
+        s->us_base = 0;
+        s->us_high = 0;
+        s->cyc_per_us = cyc_per_us ? cyc_per_us : 1u;
+    }
+
+    /* fold counter progress into the base; must run at least once per raw wrap.
+     * the sub-microsecond remainder stays in cyc_base so no time is lost.
+     */
+    static inline void timebase_state_advance(timebase_state_t *s, uint32_t raw)
+    {
+        uint32_t whole = (raw - s->cyc_base) / s->cyc_per_us;
+        uint32_t prev = s->us_base;
+
+        s->cyc_base += whole * s->cyc_per_us;
+        s->us_base = prev + whole;
+        if (s->us_base < prev)
+        {
+            s->us_high++;
+        }
+    }
+
+    /* microseconds at raw counter value (raw must be at or after cyc_base) */
+    static inline uint64_t timebase_state_us64(const timebase_state_t *s, uint32_t raw)
+    {
+        uint32_t lo = s->us_base + (raw - s->cyc_base) / s->cyc_per_us;
+        uint32_t hi = s->us_high + ((lo < s->us_base) ? 1u : 0u);
+        return ((uint64_t) hi << 32) | lo;
+    }
+
+    /* enable dwt->cyccnt and start the clock at 0 us; call after the clock tree is set */
+    bool timebase_init(void);
+
+    /* keep the base current; call from SysTick_Handler (any rate above 1/min works) */
+    void timebase_tick(void);
+
+    /* raw cycle counter (hclk ticks, wraps) for short interval measurements */
+    uint32_t timebase_cycles(void);
+
+    /* microseconds since timebase_init(); 32-bit wraps after ~71 min */
+    uint32_t timebase_now_us(void);
+    uint64_t timebase_now_us64(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMEBASE_H */
@@ -8,18 +8,152 @@
 #include "system.h"
 #include "drivers/ir/ir.h"
 #include "drivers/display/display.h"
+#include "drivers/display/display_gov.h"
+#include "drivers/buttons/buttons.h"
+#include "drivers/store/store.h"
+#include "sched/sched.h"
 #include "u8g2.h"
 
+/* display task poll period (ms); frames are capped by DISPLAY_GOV_FPS */
+#ifndef UI_PERIOD_MS
+#define UI_PERIOD_MS 10u
+#endif
+
+/* checkpoint task poll period (ms); store.h decides when a checkpoint is due */
+#ifndef STORE_POLL_MS
+#define STORE_POLL_MS 20u
+#endif
+
+/* largest target the inc button goes up to */
+#ifndef UI_TARGET_MAX
+#define UI_TARGET_MAX 99999u
+#endif
+
+static sched_id_t s_task_ir = SCHED_NONE;
+static sched_id_t s_task_buttons = SCHED_NONE;
+
+/* target count set with inc/dec (0 = none); owned by the buttons task */
+static uint32_t s_target = 0;
+
+/* drain the ir ring; the 1 ms period also confirms breaks that are still held */
+static void task_ir(void *ctx)
+{
+    (void) ctx;
+    (void) ir_process();
+}
+
+/* inc/dec step the target on press and auto-repeat; a long ok press closes
+ * the batch: all counters restart from zero without losing a break
+ */
+static void task_buttons(void *ctx)
+{
+    (void) ctx;
+
+    btn_event_t ev;
+    while (buttons_get(&ev))
+    {
+        if (ev.button == btn_ok && ev.type == BTN_EV_LONG)
+        {
+            if (ir_snapshot_reset(NULL))
+                store_flush();
+            continue;
+        }
+        if (ev.type != BTN_EV_PRESS && ev.type != BTN_EV_REPEAT)
+            continue;
+
+        if (ev.button == btn_inc && s_target < UI_TARGET_MAX)
+            s_target++;
+        else if (ev.button == btn_dec && s_target > 0u)
+            s_target--;
+    }
+}
+
+/* post count/target changes to the governor and draw what it lets through:
+ * the counters at most DISPLAY_GOV_FPS times a second, "target reached" at
+ * once. the boot banner stays up until the first count or target change
+ */
+static void task_display(void *ctx)
+{
+    static uint32_t seen_seq = 0;
+    static uint32_t seen_target = 0;
+    static bool reached = false;
+    (void) ctx;
+
+    /* stuck-bus watchdog: while i2c1 is down, display_busy() holds frames */
+    i2c_service(system_i2c1());
+
+    ir_snapshot_t snap;
+    if (!ir_snapshot(&snap))
+        return;
+
+    /* seq moves once per counted break or reset */
+    uint32_t changes = (snap.seq - seen_seq) + ((s_target != seen_target) ? 1u : 0u);
+    if (changes != 0u)
+    {
+        display_gov_post(DISPLAY_PRIO_NORMAL, changes);
+        seen_seq = snap.seq;
+        seen_target = s_target;
+    }
+
+    /* announce the target once; again after a reset or a new target */
+    bool at_target = s_target != 0u && snap.total >= s_target;
+    if (at_target && !reached)
+        display_gov_post(DISPLAY_PRIO_URGENT, 1);
+    reached = at_target;
+
+    switch (display_gov_next(HAL_GetTick()))
+    {
+        case DISPLAY_PRIO_URGENT:
+            display_show_target(snap.total, s_target);
+            break;
+        case DISPLAY_PRIO_NORMAL:
+            display_show_counts(snap.count, (uint8_t) ir_count, snap.total, s_target);
+            break;
+        default:
+            break;
+    }
+}
+
+/* counts to flash when they pause, or every STORE_PERIOD_MS while they keep
+ * changing; erases wait for a gap between breaks
+ */
+static void task_store(void *ctx)
+{
+    (void) ctx;
+    store_service(HAL_GetTick());
+}
+
+/* capture isr queued edges: run the ir task next */
+void ir_on_pending(void)
+{
+    sched_signal(s_task_ir);
+}
+
+/* debounced button events queued by the systick sampler */
+void buttons_on_pending(void)
+{
+    sched_signal(s_task_buttons);
+}
+
 int main(void)
 {
     system_init(); 
 
+    /* table order is priority: ir first */
+    sched_init();
+    s_task_ir = sched_add("ir", task_ir, NULL, 1);
+    s_task_buttons = sched_add("buttons", task_buttons, NULL, 0);
+    (void) sched_add("display", task_display, NULL, UI_PERIOD_MS);
+    (void) sched_add("store", task_store, NULL, STORE_POLL_MS);
+
     if (!ir_init())
     { 
         system_error_loop();
     }
+    /* counts from before the last power-down; without a journal they start at 0 */
+    (void) store_init();
+    buttons_init();
+    display_gov_init();
 
-    while (1)
-    {
-    }
+    sched_run();
 }
@@ -0,0 +1,144 @@
+#include "sched/sched.h"
+#include "drivers/timebase/timebase.h"
+#include "stm32f1xx_hal.h"
+
+typedef struct
+{
+    sched_fn_t fn;
+    void *ctx;
+    uint32_t next_ms; /* next periodic release */
+    sched_stats_t st;
+} sched_task_t;
+
+static sched_task_t s_tasks[SCHED_MAX_TASKS];
+static uint32_t s_ntasks = 0;
+
+/* bit n set = task n ready; or-ed by isrs, cleared by the main loop */
+static volatile uint32_t s_ready = 0;
+/* subset of s_ready released by sched_signal(), for the stats */
+static volatile uint32_t s_signaled = 0;
+static volatile uint32_t s_ms = 0;
+
+void sched_init(void)
+{
+    s_ntasks = 0;
+    s_ready = 0;
+    s_signaled = 0;
+    s_ms = 0;
+}
+
+sched_id_t sched_add(const char *name, sched_fn_t fn, void *ctx, uint32_t period_ms)
+{
+    if (!fn || s_ntasks >= SCHED_MAX_TASKS)
+        return SCHED_NONE;
+
+    sched_task_t *t = &s_tasks[s_ntasks];
+    t->fn = fn;
+    t->ctx = ctx;
+    t->next_ms = s_ms + period_ms;
+    t->st = (sched_stats_t){0};
+    t->st.name = name;
+    t->st.period_ms = period_ms;
+
+    /* publish last: sched_tick() only scans tasks below s_ntasks */
+    __atomic_store_n(&s_ntasks, s_ntasks + 1u, __ATOMIC_RELEASE);
+    return (sched_id_t) (s_ntasks - 1u);
+}
+
+void sched_signal(sched_id_t id)
+{
+    if (id >= __atomic_load_n(&s_ntasks, __ATOMIC_ACQUIRE))
+        return;
+
+    /* repeated signals before the task runs coalesce into one run */
+    (void) __atomic_fetch_or(&s_signaled, 1u << id, __ATOMIC_RELAXED);
+    (void) __atomic_fetch_or(&s_ready, 1u << id, __ATOMIC_RELEASE);
+}
+
+void sched_tick(void)
+{
+    uint32_t now = ++s_ms;
+    uint32_t n = __atomic_load_n(&s_ntasks, __ATOMIC_ACQUIRE);
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+        sched_task_t *t = &s_tasks[i];
+        if (t->st.period_ms == 0u || (int32_t) (now - t->next_ms) < 0)
+            continue;
+
+        t->next_ms += t->st.period_ms;
+        /* fell more than a period behind: drop the backlog instead of bursting */
+        if ((int32_t) (now - t->next_ms) >= 0)
+            t->next_ms = now + t->st.period_ms;
+
+        uint32_t bit = 1u << i;
+        if (__atomic_fetch_or(&s_ready, bit, __ATOMIC_RELEASE) & bit)
+        {
+            t->st.late++;
+        }
+    }
+}
+
+bool sched_run_once(void)
+{
+    uint32_t ready = __atomic_load_n(&s_ready, __ATOMIC_ACQUIRE);
+    if (ready == 0u)
+        return false;
+
+    uint32_t id = (uint32_t) __builtin_ctz(ready);
+    (void) __atomic_fetch_and(&s_ready, ~(1u << id), __ATOMIC_ACQ_REL);
+    bool signaled = (__atomic_fetch_and(&s_signaled, ~(1u << id), __ATOMIC_RELAXED) >> id) & 1u;
+
+    sched_task_t *t = &s_tasks[id];
+    uint32_t c0 = timebase_cycles();
+    t->fn(t->ctx);
+    uint32_t dt = timebase_cycles() - c0;
+
+    t->st.runs++;
+    if (signaled)
+        t->st.signaled++;
+    t->st.last_cyc = dt;
+    if (dt > t->st.wcet_cyc)
+        t->st.wcet_cyc = dt;
+    return true;
+}
+
+void sched_run(void)
+{
+    for (;;)
+    {
+        if (sched_run_once())
+            continue;
+
+        /* check and sleep with irqs masked: an isr that makes a task ready
+         * after the check still wakes wfi (pending irq), and runs right after
+         */
+        __disable_irq();
+        if (__atomic_load_n(&s_ready, __ATOMIC_ACQUIRE) == 0u)
+        {
+            __WFI();
+        }
+        __enable_irq();
+    }
+}
+
+bool sched_get_stats(sched_id_t id, sched_stats_t *out)
+{
+    if (id >= s_ntasks || !out)
+        return false;
+    *out = s_tasks[id].st;
+    return true;
+}
+
+void sched_reset_stats(void)
+{
+    for (uint32_t i = 0; i < s_ntasks; i++)
+    {
+        sched_stats_t *st = &s_tasks[i].st;
+        st->runs = 0;
+        st->signaled = 0;
+        st->late = 0;
+        st->last_cyc = 0;
+        st->wcet_cyc = 0;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* cooperative run-to-completion scheduler for the main loop
+ * - fixed task table, filled once at startup; table order is priority
+ *   (lower id runs first when several tasks are ready)
+ * - periodic tasks are released by sched_tick() from SysTick_Handler;
+ *   any task can also be released from an isr with sched_signal()
+ * - a task runs to completion in thread mode; nothing preempts it but isrs
+ * - with nothing ready the core sleeps in __WFI()
+ */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* task table size (max 32: ready set is one word) */
+#ifndef SCHED_MAX_TASKS
+#define SCHED_MAX_TASKS 8u
+#endif
+
+#if SCHED_MAX_TASKS > 32u
+#error "SCHED_MAX_TASKS must be at most 32"
+#endif
+
+#define SCHED_NONE 0xFFu
+
+    typedef uint8_t sched_id_t;
+    typedef void (*sched_fn_t)(void *ctx);
+
+    typedef struct
+    {
+        const char *name;
+        uint32_t period_ms; /* 0 = event-triggered only */
+        uint32_t runs;
+        uint32_t signaled;  /* runs released by sched_signal() */
+        uint32_t late;      /* periodic releases that found the task still pending */
+        uint32_t last_cyc;  /* last execution time, dwt cycles */
+        uint32_t wcet_cyc;  /* worst case since the last reset, dwt cycles */
+    } sched_stats_t;
+
+    void sched_init(void);
+
+    /* add a task; period_ms = 0 makes it event-triggered (sched_signal only).
+     * call before sched_run(); returns SCHED_NONE if the table is full.
+     */
+    sched_id_t sched_add(const char *name, sched_fn_t fn, void *ctx, uint32_t period_ms);
+
+    /* mark a task ready; safe from isrs and from other tasks. unknown ids are ignored */
+    void sched_signal(sched_id_t id);
+
+    /* 1 ms time base; call from SysTick_Handler */
+    void sched_tick(void);
+
+    /* run ready tasks forever, sleeping when idle */
+    void sched_run(void) __attribute__((noreturn));
+
+    /* run the highest-priority ready task, if any; false when nothing was ready */
+    bool sched_run_once(void);
+
+    /* per-task counters; false for an unknown id */
+    bool sched_get_stats(sched_id_t id, sched_stats_t *out);
+    void sched_reset_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SCHED_H */